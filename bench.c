@@ -0,0 +1,1458 @@
+// Throughput benchmarks for the BMP loading and filtering routines.
+// Usage: ./bench [--sizes 1,4,16] [--repeats N] [--warmup N] [--threads N]
+//                [--detail MP] [--json FILE]
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // syscall() for perf_event_open
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "bmp8.h"
+#include "bmp24.h"
+#include "bmp32.h"
+#include "histogram.h"
+#include "utils.h"
+#include "convolution.h"
+#include "pixelops.h"
+#include "lut.h"
+#include "pipeline.h"
+#include "planar.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define BENCH_FILE_24 "bench_tmp_24.bmp"
+#define BENCH_FILE_8 "bench_tmp_8.bmp"
+#define BENCH_FILE_OUT "bench_tmp_out.bmp"
+
+// The library reports every operation on stdout; the bench report goes to
+// a duplicate of the original stdout so those messages can be discarded.
+static FILE *report = NULL;
+
+static void bench_silence_stdout(void) {
+    fflush(stdout);
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    if (!report || !freopen("/dev/null", "w", stdout)) {
+        report = stderr;
+    }
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void print_result(const char *name, double seconds, double megapixels, double megabytes) {
+    fprintf(report, "  %-32s %9.2f ms %10.1f MP/s %10.1f MB/s\n",
+            name, seconds * 1e3, megapixels / seconds, megabytes / seconds);
+}
+
+// Writes a synthetic 24-bit image with a deterministic pattern to `filename`.
+static int write_synthetic_bmp24(const char *filename, int width, int height) {
+    t_bmp24 *img = bmp24_allocate(width, height, DEFAULT_DEPTH_24BIT);
+    if (!img) return 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            img->data[y][x].red = (uint8_t)(x * 7 + y);
+            img->data[y][x].green = (uint8_t)(x ^ y);
+            img->data[y][x].blue = (uint8_t)(y * 3);
+        }
+    }
+    bmp24_saveImage(filename, img);
+    bmp24_free(img);
+    return 1;
+}
+
+// Builds an 8-bit image in memory with a grayscale palette and a header
+// bmp8_saveImage can write
+static t_bmp8 *make_synthetic_bmp8(int width, int height) {
+    t_bmp8 *img = (t_bmp8 *)calloc(1, sizeof(t_bmp8));
+    if (!img) return NULL;
+    img->width = width;
+    img->height = height;
+    img->colorDepth = 8;
+    img->dataSize = (unsigned int)width * height;
+
+    uint32_t offset = 54 + 1024, file_size = offset + img->dataSize, info_size = DEFAULT_INFO_SIZE_VALUE;
+    uint16_t planes = 1, depth = 8;
+    img->header[0] = 'B';
+    img->header[1] = 'M';
+    memcpy(img->header + BITMAP_FILE_SIZE, &file_size, 4);
+    memcpy(img->header + BITMAP_OFFSET, &offset, 4);
+    memcpy(img->header + BITMAP_HEADER_SIZE, &info_size, 4);
+    memcpy(img->header + BITMAP_WIDTH, &width, 4);
+    memcpy(img->header + BITMAP_HEIGHT, &height, 4);
+    memcpy(img->header + BITMAP_PLANES, &planes, 2);
+    memcpy(img->header + BITMAP_DEPTH, &depth, 2);
+    memcpy(img->header + BITMAP_IMG_SIZE_RAW, &img->dataSize, 4);
+    for (int i = 0; i < 256; i++) {
+        img->colorTable[4 * i] = img->colorTable[4 * i + 1] = img->colorTable[4 * i + 2] = (unsigned char)i;
+    }
+
+    img->data = (unsigned char *)malloc(img->dataSize);
+    if (!img->data) {
+        free(img);
+        return NULL;
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            img->data[(size_t)y * width + x] = (unsigned char)((x * 7) ^ (y * 3));
+        }
+    }
+    return img;
+}
+
+// --- Reference implementations (previous code paths, kept for comparison) ---
+
+// Per-pixel stdio reader that bmp24_readPixelData replaced: one fread per pixel,
+// a seek back and a second fread of the same pixel, and a seek per row for padding.
+static void legacy_bmp24_readPixelData(t_bmp24 *image, FILE *file) {
+    int width = image->info.width;
+    int height = abs(image->info.height);
+    int padding = (4 - ((width * (int)sizeof(t_pixel)) % 4)) % 4;
+
+    fseek(file, image->header.offset, SEEK_SET);
+    for (int y_file = 0; y_file < height; y_file++) {
+        int y_mem = (image->info.height > 0) ? (height - 1 - y_file) : y_file;
+        for (int x = 0; x < width; x++) {
+            t_pixel file_px;
+            if (fread(&file_px, sizeof(t_pixel), 1, file) != 1) return;
+            fseek(file, -(long)sizeof(t_pixel), SEEK_CUR);
+            if (fread(&file_px, sizeof(t_pixel), 1, file) != 1) return;
+            image->data[y_mem][x].red = file_px.red;
+            image->data[y_mem][x].green = file_px.green;
+            image->data[y_mem][x].blue = file_px.blue;
+        }
+        if (padding > 0) fseek(file, padding, SEEK_CUR);
+    }
+}
+
+static t_bmp24 *legacy_bmp24_loadImage(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return NULL;
+    t_bmp_header header;
+    t_bmp_info info;
+    if (fread(&header, sizeof(header), 1, file) != 1 || fread(&info, sizeof(info), 1, file) != 1) {
+        fclose(file);
+        return NULL;
+    }
+    t_bmp24 *img = bmp24_allocate(info.width, abs(info.height), info.bits);
+    if (img) {
+        img->header = header;
+        img->info = info;
+        legacy_bmp24_readPixelData(img, file);
+    }
+    fclose(file);
+    return img;
+}
+
+// Byte-at-a-time point operations that u8_negative / u8_brightness / u8_threshold replaced
+static void legacy_bmp8_negative(t_bmp8 *img) {
+    for (unsigned int i = 0; i < img->dataSize; i++) img->data[i] = 255 - img->data[i];
+}
+
+static void legacy_bmp8_brightness(t_bmp8 *img, int value) {
+    for (unsigned int i = 0; i < img->dataSize; i++) {
+        img->data[i] = (unsigned char)clamp_int((int)img->data[i] + value, 0, 255);
+    }
+}
+
+static void legacy_bmp8_threshold(t_bmp8 *img, int threshold_val) {
+    for (unsigned int i = 0; i < img->dataSize; i++) img->data[i] = (img->data[i] >= threshold_val) ? 255 : 0;
+}
+
+// Single-table histogram loop that the histogram engine replaced
+static void legacy_histogram(const uint8_t *data, size_t n, unsigned int *hist) {
+    for (size_t i = 0; i < n; i++) hist[data[i]]++;
+}
+
+// --- Benchmarks ---
+
+static void bench_load24(int width, int height, int repeats) {
+    double mp = (double)width * height / 1e6;
+    double mb = mp * 3.0;
+    double best_legacy = 1e30, best_bulk = 1e30, best_map = 1e30;
+
+    for (int r = 0; r < repeats; r++) {
+        double t0 = now_seconds();
+        t_bmp24 *a = legacy_bmp24_loadImage(BENCH_FILE_24);
+        double t1 = now_seconds();
+        t_bmp24 *b = bmp24_loadImage(BENCH_FILE_24);
+        double t2 = now_seconds();
+        t_bmp24 *m = bmp24_mapImage(BENCH_FILE_24);
+        double t3 = now_seconds();
+
+        if (!a || !b || !m || bmp24_makeWritable(m) != 0) {
+            fprintf(report, "  load failed\n");
+            bmp24_free(a);
+            bmp24_free(b);
+            bmp24_free(m);
+            return;
+        }
+        for (int y = 0; y < height; y++) {
+            if (memcmp(a->data[y], b->data[y], width * sizeof(t_rgb_pixel)) != 0 ||
+                memcmp(a->data[y], m->data[y], width * sizeof(t_rgb_pixel)) != 0) {
+                fprintf(report, "  MISMATCH between readers at row %d\n", y);
+                break;
+            }
+        }
+        bmp24_free(a);
+        bmp24_free(b);
+        bmp24_free(m);
+
+        if (t1 - t0 < best_legacy) best_legacy = t1 - t0;
+        if (t2 - t1 < best_bulk) best_bulk = t2 - t1;
+        if (t3 - t2 < best_map) best_map = t3 - t2;
+    }
+
+    print_result("bmp24 load (legacy per-pixel)", best_legacy, mp, mb);
+    print_result("bmp24 load (row-buffered)", best_bulk, mp, mb);
+    print_result("bmp24 map (private mapping)", best_map, mp, mb);
+    fprintf(report, "  speedup: %.1fx\n", best_legacy / best_bulk);
+}
+
+// Load, convolve and free one image, timing each step separately
+static void bench_lifecycle24(int width, int height, int repeats) {
+    double mp = (double)width * height / 1e6;
+    double mb = mp * 3.0;
+    double best_load = 1e30, best_conv = 1e30, best_free = 1e30;
+
+    for (int r = 0; r < repeats; r++) {
+        double t0 = now_seconds();
+        t_bmp24 *img = bmp24_loadImage(BENCH_FILE_24);
+        double t1 = now_seconds();
+        if (!img) {
+            fprintf(report, "  load failed\n");
+            return;
+        }
+        bmp24_gaussianBlur(img);
+        double t2 = now_seconds();
+        bmp24_free(img);
+        double t3 = now_seconds();
+
+        if (t1 - t0 < best_load) best_load = t1 - t0;
+        if (t2 - t1 < best_conv) best_conv = t2 - t1;
+        if (t3 - t2 < best_free) best_free = t3 - t2;
+    }
+
+    print_result("bmp24_loadImage", best_load, mp, mb);
+    print_result("bmp24_gaussianBlur", best_conv, mp, mb);
+    print_result("bmp24_free", best_free, mp, mb);
+}
+
+// Point operations and filters as one pipeline (the chain of bench_pipeline)
+static void run_pipeline_chain(t_bmp24 *img) {
+    t_pipeline *pipe = pipeline_create24(img);
+    if (!pipe) return;
+    pipeline_brightness(pipe, 20);
+    pipeline_negative(pipe);
+    pipeline_gaussianBlur(pipe);
+    pipeline_sharpen(pipe);
+    pipeline_brightness(pipe, -10);
+    pipeline_materialize(pipe);
+    pipeline_free(pipe);
+}
+
+// Convolution and pipeline scaling from 1 to max_threads threads; checks every
+// run against the single-threaded output
+static void bench_threads(int width, int height, int max_threads) {
+    double mp = (double)width * height / 1e6;
+    t_bmp24 *base24 = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp8 *base8 = make_synthetic_bmp8(width, height);
+    t_bmp24 *ref24 = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp24 *ref_pipe = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp8 *ref8 = make_synthetic_bmp8(width, height);
+    t_bmp24 *work24 = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp24 *work_pipe = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp8 *work8 = make_synthetic_bmp8(width, height);
+    if (!base24 || !base8 || !ref24 || !ref_pipe || !ref8 || !work24 || !work_pipe || !work8) {
+        fprintf(report, "  allocation failed\n");
+        goto done;
+    }
+    size_t size24 = base24->stride * height;
+
+    double t1_8 = 0, t1_24 = 0, t1_pipe = 0;
+    // 1, 2, 4, ... and always end on max_threads
+    for (int threads = 1; threads <= max_threads;
+         threads = (threads < max_threads && threads * 2 > max_threads) ? max_threads : threads * 2) {
+        set_num_threads(threads);
+
+        memcpy(work8->data, base8->data, work8->dataSize);
+        double t0 = now_seconds();
+        bmp8_gaussianBlur(work8);
+        double t8 = now_seconds() - t0;
+
+        memcpy(work24->pixels, base24->pixels, size24);
+        t0 = now_seconds();
+        bmp24_gaussianBlur(work24);
+        double t24 = now_seconds() - t0;
+
+        memcpy(work_pipe->pixels, base24->pixels, size24);
+        t0 = now_seconds();
+        run_pipeline_chain(work_pipe);
+        double t_pipe = now_seconds() - t0;
+
+        if (threads == 1) {
+            t1_8 = t8;
+            t1_24 = t24;
+            t1_pipe = t_pipe;
+            memcpy(ref8->data, work8->data, work8->dataSize);
+            memcpy(ref24->pixels, work24->pixels, size24);
+            memcpy(ref_pipe->pixels, work_pipe->pixels, size24);
+        }
+        int same = memcmp(ref8->data, work8->data, work8->dataSize) == 0 &&
+                   memcmp(ref24->pixels, work24->pixels, size24) == 0 &&
+                   memcmp(ref_pipe->pixels, work_pipe->pixels, size24) == 0;
+
+        fprintf(report, "  %2d threads: bmp8 %8.2f ms (%5.2fx)  bmp24 %8.2f ms (%5.2fx)  %.1f MP/s"
+                "  pipeline %8.2f ms (%5.2fx)  %s\n",
+                threads, t8 * 1e3, t1_8 / t8, t24 * 1e3, t1_24 / t24, mp / t24,
+                t_pipe * 1e3, t1_pipe / t_pipe, same ? "identical" : "MISMATCH");
+    }
+    set_num_threads(0);
+
+done:
+    bmp24_free(base24);
+    bmp24_free(ref24);
+    bmp24_free(ref_pipe);
+    bmp24_free(work24);
+    bmp24_free(work_pipe);
+    bmp8_free(base8);
+    bmp8_free(ref8);
+    bmp8_free(work8);
+}
+
+// --- Previous parallel_for: new threads on every call ---
+
+typedef struct {
+    t_range_fn body;
+    void *ctx;
+    int begin;
+    int end;
+} t_legacy_band;
+
+static void *legacy_run_band(void *arg) {
+    t_legacy_band *band = (t_legacy_band *)arg;
+    band->body(band->begin, band->end, band->ctx);
+    return NULL;
+}
+
+static void legacy_parallel_for(int begin, int end, t_range_fn body, void *ctx, int threads) {
+    int count = end - begin;
+    t_legacy_band bands[64];
+    pthread_t tids[64];
+    int started[64] = {0};
+    if (threads > 64) threads = 64;
+    if (threads > count) threads = count;
+    for (int t = 0; t < threads; t++) {
+        t_legacy_band band = {body, ctx, begin + (int)((long long)count * t / threads),
+                              begin + (int)((long long)count * (t + 1) / threads)};
+        bands[t] = band;
+    }
+    for (int t = 1; t < threads; t++) started[t] = pthread_create(&tids[t], NULL, legacy_run_band, &bands[t]) == 0;
+    legacy_run_band(&bands[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(tids[t], NULL);
+        else legacy_run_band(&bands[t]);
+    }
+}
+
+typedef struct {
+    const uint8_t *src;
+    int width;
+    volatile unsigned int sink;
+} t_dispatch_job;
+
+// A few microseconds of work per row, about what a point operation spends on a small image
+static void dispatch_rows(int begin, int end, void *ctx) {
+    t_dispatch_job *job = (t_dispatch_job *)ctx;
+    unsigned int sum = 0;
+    for (int y = begin; y < end; y++) {
+        for (int x = 0; x < job->width; x++) sum += job->src[(size_t)y * job->width + x];
+    }
+    job->sink += sum;
+}
+
+// Cost of one parallel_for call on a small job: the persistent pool against
+// creating and joining threads on every call as before
+static void bench_dispatch(int threads, int repeats) {
+    int width = 1024, height = 64, calls = 2000;
+    uint8_t *src = (uint8_t *)calloc((size_t)width * height, 1);
+    if (!src) {
+        fprintf(report, "  allocation failed\n");
+        return;
+    }
+    t_dispatch_job job = {src, width, 0};
+    set_num_threads(threads);
+    parallel_for(0, height, dispatch_rows, &job); // Pool started outside the timing
+
+    double best_legacy = 1e30, best_pool = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        double t0 = now_seconds();
+        for (int c = 0; c < calls; c++) legacy_parallel_for(0, height, dispatch_rows, &job, threads);
+        double t1 = now_seconds();
+        for (int c = 0; c < calls; c++) parallel_for(0, height, dispatch_rows, &job);
+        double t2 = now_seconds();
+        if (t1 - t0 < best_legacy) best_legacy = t1 - t0;
+        if (t2 - t1 < best_pool) best_pool = t2 - t1;
+    }
+    fprintf(report, "  %d threads, %d calls on 64 KB: new threads %8.2f us/call  pool %8.2f us/call  (%.1fx)\n",
+            threads, calls, best_legacy / calls * 1e6, best_pool / calls * 1e6, best_legacy / best_pool);
+    free(src);
+}
+
+typedef enum { SCRATCH_SHARPEN, SCRATCH_EQUALIZE, SCRATCH_CLAHE, SCRATCH_PIPELINE, SCRATCH_OPS } t_scratch_op;
+
+static void scratch_run(t_scratch_op op, t_bmp24 *img) {
+    t_pipeline *pipe = NULL;
+    switch (op) {
+        case SCRATCH_SHARPEN: bmp24_sharpen(img); break;
+        case SCRATCH_EQUALIZE: bmp24_equalize(img); break;
+        case SCRATCH_CLAHE: bmp24_clahe(img, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_CLIP_LIMIT); break;
+        case SCRATCH_PIPELINE:
+            pipe = pipeline_create24(img);
+            if (!pipe) break;
+            pipeline_gaussianBlur(pipe);
+            pipeline_sharpen(pipe);
+            pipeline_equalize(pipe);
+            pipeline_materialize(pipe);
+            pipeline_free(pipe);
+            break;
+        default: break;
+    }
+}
+
+// Blocks the scratch arenas allocate on the first call of an operation and on
+// the calls that follow on the same image (the second number should be 0)
+static void bench_scratch(int repeats) {
+    t_bmp24 *img = bmp24_loadImage(BENCH_FILE_24);
+    if (!img) {
+        fprintf(report, "  allocation failed\n");
+        return;
+    }
+    const char *names[SCRATCH_OPS] = {"sharpen", "equalize", "clahe", "pipeline(gauss+sharpen+eq)"};
+    for (int op = 0; op < SCRATCH_OPS; op++) {
+        // Empty arenas everywhere: the workers free theirs as they exit
+        thread_pool_stop();
+        scratch_arena_free();
+        unsigned long before = arena_heap_allocations();
+        scratch_run((t_scratch_op)op, img);
+        unsigned long first = arena_heap_allocations() - before;
+        // A worker that got no band on the first call warms up on a later one
+        scratch_run((t_scratch_op)op, img);
+        before = arena_heap_allocations();
+        for (int r = 0; r < repeats; r++) scratch_run((t_scratch_op)op, img);
+        fprintf(report, "  %-28s first call %3lu arena blocks   next %d calls %3lu\n",
+                names[op], first, repeats, arena_heap_allocations() - before);
+    }
+    bmp24_free(img);
+}
+
+// Scalar reference loops vs the dispatched vector kernels; results must match
+static void bench_pointops8(int width, int height, int repeats) {
+    double mp = (double)width * height / 1e6;
+    t_bmp8 *a = make_synthetic_bmp8(width, height);
+    t_bmp8 *b = make_synthetic_bmp8(width, height);
+    if (!a || !b) {
+        fprintf(report, "  allocation failed\n");
+        bmp8_free(a);
+        bmp8_free(b);
+        return;
+    }
+    const char *names[3] = {"negative", "brightness(+40)", "threshold(128)"};
+    for (int op = 0; op < 3; op++) {
+        double best_legacy = 1e30, best_simd = 1e30;
+        for (int r = 0; r < repeats; r++) {
+            double t0 = now_seconds();
+            if (op == 0) legacy_bmp8_negative(a);
+            if (op == 1) legacy_bmp8_brightness(a, 40);
+            if (op == 2) legacy_bmp8_threshold(a, 128);
+            double t1 = now_seconds();
+            if (op == 0) bmp8_negative(b);
+            if (op == 1) bmp8_brightness(b, 40);
+            if (op == 2) bmp8_threshold(b, 128);
+            double t2 = now_seconds();
+            if (t1 - t0 < best_legacy) best_legacy = t1 - t0;
+            if (t2 - t1 < best_simd) best_simd = t2 - t1;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "%s (scalar)", names[op]);
+        print_result(name, best_legacy, mp, mp);
+        snprintf(name, sizeof(name), "%s (%s)", names[op], u8_simd_level());
+        print_result(name, best_simd, mp, mp);
+        if (memcmp(a->data, b->data, a->dataSize) != 0) fprintf(report, "  MISMATCH\n");
+    }
+    bmp8_free(a);
+    bmp8_free(b);
+}
+
+// Full 2D vs separable Gaussian blur for kernel sizes 3..31 on a 1 MP 8-bit image
+static void bench_separable(void) {
+    int width = 1001, height = 1000;
+    t_bmp8 *src = make_synthetic_bmp8(width, height);
+    uint8_t *out_2d = (uint8_t *)malloc((size_t)width * height);
+    uint8_t *out_sep = (uint8_t *)malloc((size_t)width * height);
+    float *factors = (float *)malloc(2 * 31 * sizeof(float));
+    if (!src || !out_2d || !out_sep || !factors) {
+        fprintf(report, "  allocation failed\n");
+        goto done;
+    }
+
+    for (int k = 3; k <= 31; k += 4) {
+        float **kernel = create_gaussian_kernel(k, 0.0f);
+        if (!kernel || !kernel_separate(kernel, k, factors, factors + k)) {
+            fprintf(report, "  %2dx%-2d: kernel not separable\n", k, k);
+            free_kernel(kernel, k);
+            continue;
+        }
+        memcpy(out_2d, src->data, src->dataSize);
+        memcpy(out_sep, src->data, src->dataSize);
+
+        double t0 = now_seconds();
+        convolve_2d_u8(src->data, out_2d, width, height, width, 1, kernel, k);
+        double t1 = now_seconds();
+        convolve_separable_u8(src->data, out_sep, width, height, width, 1, factors, factors + k, k);
+        double t2 = now_seconds();
+
+        int max_diff = 0;
+        for (unsigned int i = 0; i < src->dataSize; i++) {
+            int d = abs((int)out_2d[i] - (int)out_sep[i]);
+            if (d > max_diff) max_diff = d;
+        }
+        fprintf(report, "  %2dx%-2d: 2D %9.2f ms  separable %7.2f ms  (%5.1fx)  max diff %d\n",
+                k, k, (t1 - t0) * 1e3, (t2 - t1) * 1e3, (t1 - t0) / (t2 - t1), max_diff);
+        free_kernel(kernel, k);
+    }
+
+done:
+    bmp8_free(src);
+    free(out_2d);
+    free(out_sep);
+    free(factors);
+}
+
+// bmp24_boxBlurRadius for growing radii: the cost per pixel should stay flat
+static void bench_box_radius(int repeats) {
+    int width = 2001, height = 1500;
+    double mp = (double)width * height / 1e6;
+    t_bmp24 *img = bmp24_allocate(width, height, DEFAULT_DEPTH_24BIT);
+    if (!img) {
+        fprintf(report, "  allocation failed\n");
+        return;
+    }
+    for (size_t i = 0; i < img->stride * height; i++) img->pixels[i] = (uint8_t)(i * 2654435761u >> 24);
+
+    int radii[] = {1, 2, 4, 8, 16, 32, 64, 128};
+    for (size_t r = 0; r < sizeof(radii) / sizeof(radii[0]); r++) {
+        double best = 1e30;
+        for (int i = 0; i < repeats; i++) {
+            double t0 = now_seconds();
+            bmp24_boxBlurRadius(img, radii[r]);
+            double t1 = now_seconds();
+            if (t1 - t0 < best) best = t1 - t0;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "radius %3d (%dx%d window)", radii[r], 2 * radii[r] + 1, 2 * radii[r] + 1);
+        print_result(name, best, mp, mp * 3.0);
+    }
+    bmp24_free(img);
+}
+
+// Fixed-point vs float convolution for every built-in kernel on a noisy 1 MP
+// 8-bit image: timing, quantization shift and maximum error
+static void bench_fixed_point(void) {
+    int width = 1001, height = 1000;
+    t_bmp8 *src = make_synthetic_bmp8(width, height);
+    uint8_t *out_float = (uint8_t *)malloc((size_t)width * height);
+    uint8_t *out_fixed = (uint8_t *)malloc((size_t)width * height);
+    if (!src || !out_float || !out_fixed) {
+        fprintf(report, "  allocation failed\n");
+        goto done;
+    }
+    // Noise exercises every rounding case, the pattern alone is too regular
+    uint32_t seed = 12345;
+    for (unsigned int i = 0; i < src->dataSize; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        src->data[i] = (uint8_t)(seed >> 24);
+    }
+
+    const char *names[5] = {"box blur", "gaussian blur", "outline", "emboss", "sharpen"};
+    float **kernels[5] = {BOX_BLUR_KERNEL, GAUSSIAN_BLUR_KERNEL, OUTLINE_KERNEL, EMBOSS_KERNEL, SHARPEN_KERNEL};
+    for (int k = 0; k < 5; k++) {
+        t_fixed_kernel fixed;
+        if (!fixed_kernel_quantize(kernels[k], KERNEL_SIZE_3x3, &fixed)) {
+            fprintf(report, "  %-14s not representable\n", names[k]);
+            continue;
+        }
+        memcpy(out_float, src->data, src->dataSize);
+        memcpy(out_fixed, src->data, src->dataSize);
+
+        double t0 = now_seconds();
+        convolve_2d_u8(src->data, out_float, width, height, width, 1, kernels[k], KERNEL_SIZE_3x3);
+        double t1 = now_seconds();
+        convolve_fixed_u8(src->data, out_fixed, width, height, width, 1, &fixed);
+        double t2 = now_seconds();
+
+        int max_err = 0;
+        unsigned int differing = 0;
+        for (unsigned int i = 0; i < src->dataSize; i++) {
+            int d = abs((int)out_float[i] - (int)out_fixed[i]);
+            if (d > max_err) max_err = d;
+            if (d) differing++;
+        }
+        fprintf(report, "  %-14s shift %2d  float %7.2f ms  fixed %7.2f ms  (%4.1fx)  max error %d (%u pixels)\n",
+                names[k], fixed.shift, (t1 - t0) * 1e3, (t2 - t1) * 1e3, (t1 - t0) / (t2 - t1), max_err, differing);
+        fixed_kernel_free(&fixed);
+    }
+
+done:
+    bmp8_free(src);
+    free(out_float);
+    free(out_fixed);
+}
+
+// Filters on a copy of the image (the previous code path) vs in place
+static void bench_inplace(int width, int height, int repeats) {
+    double mp = (double)width * height / 1e6;
+    t_bmp24 *img = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp24 *a = bmp24_loadImage(BENCH_FILE_24);
+    if (!img || !a) {
+        fprintf(report, "  allocation failed\n");
+        goto done;
+    }
+    size_t size = img->stride * height;
+
+    const char *names[3] = {"gaussian blur", "sharpen", "box radius 8"};
+    for (int f = 0; f < 3; f++) {
+        double best_copy = 1e30, best_inplace = 1e30;
+        int same = 1;
+        for (int r = 0; r < repeats; r++) {
+            memcpy(a->pixels, img->pixels, size);
+            double t0 = now_seconds();
+            uint8_t *copy = (uint8_t *)malloc(size);
+            if (!copy) break;
+            memcpy(copy, a->pixels, size);
+            if (f == 0) convolve_u8(copy, a->pixels, width, height, a->stride, 3, GAUSSIAN_BLUR_KERNEL, KERNEL_SIZE_3x3);
+            else if (f == 1) convolve_u8(copy, a->pixels, width, height, a->stride, 3, SHARPEN_KERNEL, KERNEL_SIZE_3x3);
+            else convolve_box_u8(copy, a->pixels, width, height, a->stride, 3, 8);
+            double t1 = now_seconds();
+
+            // The copy now serves as the input of the in-place run
+            memcpy(copy, img->pixels, size);
+            double t2 = now_seconds();
+            if (f == 0) convolve_inplace_u8(copy, width, height, a->stride, 3, GAUSSIAN_BLUR_KERNEL, KERNEL_SIZE_3x3);
+            else if (f == 1) convolve_inplace_u8(copy, width, height, a->stride, 3, SHARPEN_KERNEL, KERNEL_SIZE_3x3);
+            else convolve_box_inplace_u8(copy, width, height, a->stride, 3, 8);
+            double t3 = now_seconds();
+
+            if (memcmp(copy, a->pixels, size) != 0) same = 0;
+            free(copy);
+            if (t1 - t0 < best_copy) best_copy = t1 - t0;
+            if (t3 - t2 < best_inplace) best_inplace = t3 - t2;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "%s, full copy", names[f]);
+        print_result(name, best_copy, mp, mp * 3.0);
+        snprintf(name, sizeof(name), "%s, in place", names[f]);
+        print_result(name, best_inplace, mp, mp * 3.0);
+        fprintf(report, "  speedup: %.2fx  %s\n", best_copy / best_inplace, same ? "identical" : "MISMATCH");
+    }
+    // In place, radius 8: a window of 64 + 2 * 8 rows per thread, and 2 * 8 rows
+    // saved per boundary between threads
+    int threads = get_num_threads();
+    double inplace_rows = (64.0 + 16) * threads + 16.0 * (threads - 1);
+    fprintf(report, "  extra memory: full copy %.1f MB, in place %.2f MB (box radius 8, %d threads)\n",
+            size / 1e6, inplace_rows * img->stride / 1e6, threads);
+
+done:
+    bmp24_free(img);
+    bmp24_free(a);
+}
+
+// Same filters on 3-byte and 4-byte pixels holding the same colors
+static void bench_pixels32(int width, int height, int repeats) {
+    double mp = (double)width * height / 1e6;
+    t_bmp24 *base = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp24 *a = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp32 *base32 = bmp32_allocate(width, height);
+    t_bmp32 *b = bmp32_allocate(width, height);
+    if (!base || !a || !base32 || !b) {
+        fprintf(report, "  allocation failed\n");
+        goto done;
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            t_rgb_pixel p = base->data[y][x];
+            t_rgba_pixel q = {p.red, p.green, p.blue, (uint8_t)(x + y)};
+            base32->data[y][x] = q;
+        }
+    }
+
+    const char *names[5] = {"negative", "brightness", "gaussian blur", "sharpen", "box radius 8"};
+    for (int f = 0; f < 5; f++) {
+        double best24 = 1e30, best32 = 1e30;
+        int same = 1;
+        for (int r = 0; r < repeats; r++) {
+            memcpy(a->pixels, base->pixels, a->stride * height);
+            memcpy(b->pixels, base32->pixels, b->stride * height);
+            double t0 = now_seconds();
+            if (f == 0) bmp24_negative(a);
+            else if (f == 1) bmp24_brightness(a, 40);
+            else if (f == 2) bmp24_gaussianBlur(a);
+            else if (f == 3) bmp24_sharpen(a);
+            else bmp24_boxBlurRadius(a, 8);
+            double t1 = now_seconds();
+            if (f == 0) bmp32_negative(b);
+            else if (f == 1) bmp32_brightness(b, 40);
+            else if (f == 2) bmp32_gaussianBlur(b);
+            else if (f == 3) bmp32_sharpen(b);
+            else bmp32_boxBlurRadius(b, 8);
+            double t2 = now_seconds();
+
+            for (int y = 0; y < height && same; y++) {
+                for (int x = 0; x < width; x++) {
+                    t_rgb_pixel p = a->data[y][x];
+                    t_rgba_pixel q = b->data[y][x];
+                    if (p.red != q.red || p.green != q.green || p.blue != q.blue || q.alpha != (uint8_t)(x + y)) same = 0;
+                }
+            }
+            if (t1 - t0 < best24) best24 = t1 - t0;
+            if (t2 - t1 < best32) best32 = t2 - t1;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "%s, 24-bit", names[f]);
+        print_result(name, best24, mp, mp * 3.0);
+        snprintf(name, sizeof(name), "%s, 32-bit", names[f]);
+        print_result(name, best32, mp, mp * 4.0);
+        fprintf(report, "  32-bit / 24-bit time: %.2f  %s\n", best32 / best24, same ? "same colors, alpha kept" : "MISMATCH");
+    }
+
+done:
+    bmp24_free(base);
+    bmp24_free(a);
+    bmp32_free(base32);
+    bmp32_free(b);
+}
+
+// Per-channel equalization on interleaved pixels: the reference for planar24_equalize
+static void interleaved_equalize_channels(t_bmp24 *img) {
+    int height = abs(img->info.height);
+    unsigned int *hist = bmp24_computeHistograms(img);
+    if (!hist) return;
+    t_lut lut;
+    lut_init(&lut, 3);
+    for (int c = 0; c < 3; c++) {
+        unsigned int *map = bmp8_computeAndNormalizeCDF(hist + c * 256, (unsigned int)img->info.width * height);
+        if (map) lut_remap(&lut, c, map);
+        free(map);
+    }
+    lut_apply_u8(&lut, img->pixels, img->info.width, height, img->stride, 3);
+    free(hist);
+}
+
+// Same operations on interleaved R,G,B pixels and on three planes, with and
+// without the cost of splitting the image and merging it back
+static void bench_planar(int width, int height, int repeats) {
+    double mp = (double)width * height / 1e6;
+    t_bmp24 *base = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp24 *a = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp24 *b = bmp24_loadImage(BENCH_FILE_24);
+    t_planar24 *p = planar24_allocate(width, height);
+    if (!base || !a || !b || !p) {
+        fprintf(report, "  allocation failed\n");
+        goto done;
+    }
+
+    double split = 1e30, merge = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        double t0 = now_seconds();
+        bmp24_splitPlanes(base, p);
+        double t1 = now_seconds();
+        bmp24_mergePlanes(b, p);
+        double t2 = now_seconds();
+        if (t1 - t0 < split) split = t1 - t0;
+        if (t2 - t1 < merge) merge = t2 - t1;
+    }
+    print_result("split into planes", split, mp, mp * 6.0);
+    print_result("merge planes", merge, mp, mp * 6.0);
+    fprintf(report, "  round trip: %s\n", memcmp(b->pixels, base->pixels, b->stride * height) == 0 ? "exact" : "MISMATCH");
+
+    float **gaussian5 = create_gaussian_kernel(5, 0.0f);
+    const char *names[6] = {"brightness", "gaussian blur", "sharpen", "gaussian 5x5", "box radius 8", "equalize per channel"};
+    for (int f = 0; f < 6; f++) {
+        double bestI = 1e30, bestP = 1e30;
+        int same = 1;
+        for (int r = 0; r < repeats; r++) {
+            memcpy(a->pixels, base->pixels, a->stride * height);
+            bmp24_splitPlanes(base, p);
+            double t0 = now_seconds();
+            if (f == 0) bmp24_brightness(a, 40);
+            else if (f == 1) bmp24_gaussianBlur(a);
+            else if (f == 2) bmp24_sharpen(a);
+            else if (f == 3) convolve_inplace_u8(a->pixels, width, height, a->stride, 3, gaussian5, 5);
+            else if (f == 4) bmp24_boxBlurRadius(a, 8);
+            else interleaved_equalize_channels(a);
+            double t1 = now_seconds();
+            if (f == 0) planar24_brightness(p, 40);
+            else if (f == 1) planar24_applyFilter(p, GAUSSIAN_BLUR_KERNEL, KERNEL_SIZE_3x3);
+            else if (f == 2) planar24_applyFilter(p, SHARPEN_KERNEL, KERNEL_SIZE_3x3);
+            else if (f == 3) planar24_applyFilter(p, gaussian5, 5);
+            else if (f == 4) planar24_boxBlurRadius(p, 8);
+            else planar24_equalize(p);
+            double t2 = now_seconds();
+
+            bmp24_mergePlanes(b, p);
+            // Row padding is not part of the planes
+            for (int y = 0; y < height && same; y++) {
+                if (memcmp(a->data[y], b->data[y], (size_t)width * 3) != 0) same = 0;
+            }
+            if (t1 - t0 < bestI) bestI = t1 - t0;
+            if (t2 - t1 < bestP) bestP = t2 - t1;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "%s, interleaved", names[f]);
+        print_result(name, bestI, mp, mp * 3.0);
+        snprintf(name, sizeof(name), "%s, planar", names[f]);
+        print_result(name, bestP, mp, mp * 3.0);
+        fprintf(report, "  planar / interleaved time: %.2f (%.2f with split + merge)  %s\n",
+                bestP / bestI, (bestP + split + merge) / bestI, same ? "same result" : "MISMATCH");
+    }
+    free_kernel(gaussian5, 5);
+
+done:
+    bmp24_free(base);
+    bmp24_free(a);
+    bmp24_free(b);
+    planar24_free(p);
+}
+
+// --- Hardware counters (Linux perf_event_open) ---
+// Counted for the calling thread and the pool workers: the pool is restarted
+// inside the measurement so its threads inherit the counters, and stopped before
+// reading them, which is when their counts are added (thread creation is a few
+// tens of microseconds against filters of several milliseconds). Unavailable
+// without Linux or without permission (perf_event_paranoid, containers): the
+// counters then read as -1 and only the timings are reported.
+
+typedef enum { PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_COUNTERS } t_perf_counter;
+
+typedef struct {
+    int fd[PERF_COUNTERS];
+} t_perf;
+
+static void perf_start(t_perf *perf) {
+    thread_pool_stop(); // Started again by the next parallel_for, under the counters
+#ifdef __linux__
+    uint32_t types[PERF_COUNTERS] = {PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE};
+    uint64_t configs[PERF_COUNTERS] = {
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES};
+    for (int c = 0; c < PERF_COUNTERS; c++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = types[c];
+        attr.config = configs[c];
+        attr.disabled = 1;
+        attr.inherit = 1; // Pool workers, added to the count when they exit
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        perf->fd[c] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        if (perf->fd[c] >= 0) {
+            ioctl(perf->fd[c], PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf->fd[c], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    for (int c = 0; c < PERF_COUNTERS; c++) perf->fd[c] = -1;
+#endif
+}
+
+// Stops the counters and stores their values (-1 when unavailable)
+static void perf_stop(t_perf *perf, long long *values) {
+    thread_pool_stop();
+    for (int c = 0; c < PERF_COUNTERS; c++) {
+        values[c] = -1;
+#ifdef __linux__
+        if (perf->fd[c] < 0) continue;
+        ioctl(perf->fd[c], PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(perf->fd[c], &count, sizeof(count)) == (ssize_t)sizeof(count)) values[c] = count;
+        close(perf->fd[c]);
+#endif
+    }
+}
+
+static void print_misses(const char *label, long long misses, double pixels) {
+    if (misses < 0) fprintf(report, "  %12s n/a", label);
+    else fprintf(report, "  %12s %6.3f/px", label, misses / pixels);
+}
+
+// Filters on a wide 24-bit image (32768 pixels per row) with whole rows and
+// with column tiles: time plus L1D and last-level cache misses per pixel
+static void bench_tiles(int repeats) {
+    int width = 32768, height = 96;
+    double pixels = (double)width * height;
+    size_t stride = (size_t)width * 3;
+    uint8_t *src = (uint8_t *)malloc(stride * height);
+    uint8_t *dst = (uint8_t *)malloc(stride * height);
+    uint8_t *reference = (uint8_t *)malloc(stride * height);
+    if (!src || !dst || !reference) {
+        fprintf(report, "  allocation failed\n");
+        goto done;
+    }
+    for (size_t i = 0; i < stride * height; i++) src[i] = (uint8_t)(i * 2654435761u >> 24);
+
+    const char *names[4] = {"gaussian (separable)", "sharpen (2D)", "sharpen (fixed)", "box radius 4"};
+    int previous_tile = get_convolution_tile_width();
+    t_conv_precision previous_precision = get_convolution_precision();
+    int unavailable = 0;
+    for (int f = 0; f < 4; f++) {
+        int tiles[2] = {CONV_TILE_OFF, CONV_TILE_AUTO};
+        for (int t = 0; t < 2; t++) {
+            set_convolution_tile_width(tiles[t]);
+            set_convolution_precision(f == 2 ? CONV_PRECISION_FIXED : CONV_PRECISION_FLOAT);
+            double best = 1e30;
+            long long best_counts[PERF_COUNTERS] = {-1, -1};
+            for (int r = 0; r < repeats; r++) {
+                memcpy(dst, src, stride * height);
+                long long counts[PERF_COUNTERS];
+                t_perf perf;
+                perf_start(&perf);
+                double t0 = now_seconds();
+                if (f == 0) convolve_u8(src, dst, width, height, stride, 3, GAUSSIAN_BLUR_KERNEL, KERNEL_SIZE_3x3);
+                else if (f == 3) convolve_box_u8(src, dst, width, height, stride, 3, 4);
+                else convolve_u8(src, dst, width, height, stride, 3, SHARPEN_KERNEL, KERNEL_SIZE_3x3);
+                double t1 = now_seconds();
+                perf_stop(&perf, counts);
+                if (t1 - t0 < best) {
+                    best = t1 - t0;
+                    memcpy(best_counts, counts, sizeof(counts));
+                }
+            }
+            if (best_counts[PERF_L1D_MISSES] < 0 && best_counts[PERF_LLC_MISSES] < 0) unavailable = 1;
+            if (t == 0) memcpy(reference, dst, stride * height);
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s, %s", names[f], t == 0 ? "rows" : "tiles");
+            fprintf(report, "  %-32s %9.2f ms", name, best * 1e3);
+            print_misses("L1D misses", best_counts[PERF_L1D_MISSES], pixels);
+            print_misses("LLC misses", best_counts[PERF_LLC_MISSES], pixels);
+            if (t == 1) fprintf(report, "  %s", memcmp(reference, dst, stride * height) == 0 ? "identical" : "MISMATCH");
+            fprintf(report, "\n");
+        }
+    }
+    if (unavailable) fprintf(report, "  (cache counters unavailable: no perf_event_open access)\n");
+    set_convolution_tile_width(previous_tile);
+    set_convolution_precision(previous_precision);
+
+done:
+    free(src);
+    free(dst);
+    free(reference);
+}
+
+// Per-pixel float rgb_to_yuv / yuv_to_rgb vs the fixed-point row conversions
+// on a 3 MP noise image: RGB -> YUV -> RGB round trip and its maximum error
+static void bench_yuv(int repeats) {
+    int width = 2001, height = 1500;
+    double mp = (double)width * height / 1e6;
+    t_bmp24 *img = bmp24_allocate(width, height, DEFAULT_DEPTH_24BIT);
+    t_yuv_pixel *yuv = (t_yuv_pixel *)malloc(width * sizeof(t_yuv_pixel));
+    uint8_t *y_plane = (uint8_t *)malloc(width);
+    int16_t *u_plane = (int16_t *)malloc(width * sizeof(int16_t));
+    int16_t *v_plane = (int16_t *)malloc(width * sizeof(int16_t));
+    t_rgb_pixel *out_float = (t_rgb_pixel *)malloc(width * sizeof(t_rgb_pixel));
+    t_rgb_pixel *out_fixed = (t_rgb_pixel *)malloc(width * sizeof(t_rgb_pixel));
+    if (!img || !yuv || !y_plane || !u_plane || !v_plane || !out_float || !out_fixed) {
+        fprintf(report, "  allocation failed\n");
+        goto done;
+    }
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < img->stride * height; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        img->pixels[i] = (uint8_t)(seed >> 24);
+    }
+
+    double best_float = 1e30, best_fixed = 1e30;
+    int max_err = 0;
+    for (int r = 0; r < repeats; r++) {
+        double t_float = 0, t_fixed = 0;
+        for (int y = 0; y < height; y++) {
+            double t0 = now_seconds();
+            for (int x = 0; x < width; x++) yuv[x] = rgb_to_yuv(img->data[y][x]);
+            for (int x = 0; x < width; x++) out_float[x] = yuv_to_rgb(yuv[x]);
+            double t1 = now_seconds();
+            rgb_row_to_yuv(img->data[y], y_plane, u_plane, v_plane, width);
+            yuv_row_to_rgb(y_plane, u_plane, v_plane, out_fixed, width);
+            double t2 = now_seconds();
+            t_float += t1 - t0;
+            t_fixed += t2 - t1;
+
+            if (r > 0) continue;
+            const uint8_t *a = (const uint8_t *)out_float, *b = (const uint8_t *)out_fixed;
+            for (size_t i = 0; i < width * sizeof(t_rgb_pixel); i++) {
+                int d = abs((int)a[i] - (int)b[i]);
+                if (d > max_err) max_err = d;
+            }
+        }
+        if (t_float < best_float) best_float = t_float;
+        if (t_fixed < best_fixed) best_fixed = t_fixed;
+    }
+    print_result("round trip (float, per pixel)", best_float, mp, mp * 3.0);
+    print_result("round trip (fixed, per row)", best_fixed, mp, mp * 3.0);
+    fprintf(report, "  speedup: %.1fx, max error vs float %d\n", best_float / best_fixed, max_err);
+
+done:
+    bmp24_free(img);
+    free(yuv);
+    free(y_plane);
+    free(u_plane);
+    free(v_plane);
+    free(out_float);
+    free(out_fixed);
+}
+
+// Single-table loop vs the histogram engine on the pattern image and on a
+// constant image (every pixel hits the same counter); counts must match
+static void bench_histogram(int width, int height, int repeats) {
+    double mp = (double)width * height / 1e6;
+    t_bmp8 *img = make_synthetic_bmp8(width, height);
+    if (!img) {
+        fprintf(report, "  allocation failed\n");
+        return;
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) memset(img->data, 77, img->dataSize);
+        unsigned int legacy[256], engine[256];
+        double best_legacy = 1e30, best_engine = 1e30;
+        for (int r = 0; r < repeats; r++) {
+            memset(legacy, 0, sizeof(legacy));
+            memset(engine, 0, sizeof(engine));
+            double t0 = now_seconds();
+            legacy_histogram(img->data, img->dataSize, legacy);
+            double t1 = now_seconds();
+            histogram_count_flat_u8(img->data, img->dataSize, engine);
+            double t2 = now_seconds();
+            if (t1 - t0 < best_legacy) best_legacy = t1 - t0;
+            if (t2 - t1 < best_engine) best_engine = t2 - t1;
+        }
+        const char *image = pass ? "constant" : "pattern";
+        char name[64];
+        snprintf(name, sizeof(name), "%s (single table)", image);
+        print_result(name, best_legacy, mp, mp);
+        snprintf(name, sizeof(name), "%s (engine)", image);
+        print_result(name, best_engine, mp, mp);
+        if (memcmp(legacy, engine, sizeof(legacy)) != 0) fprintf(report, "  MISMATCH\n");
+    }
+    bmp8_free(img);
+}
+
+// Five point operations run one after the other vs the same chain compiled
+// into one lookup table per channel and applied in a single pass
+static void bench_lut_chain(int width, int height, int repeats) {
+    double mp = (double)width * height / 1e6;
+    t_bmp24 *base = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp24 *a = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp24 *b = bmp24_loadImage(BENCH_FILE_24);
+    if (!base || !a || !b) {
+        fprintf(report, "  allocation failed\n");
+        goto done;
+    }
+    size_t size = base->stride * height;
+
+    // Tone curve on red only, then the same steps on every channel
+    unsigned int curve[256];
+    for (int v = 0; v < 256; v++) curve[v] = (unsigned int)(255.0 * pow(v / 255.0, 0.8) + 0.5);
+
+    double best_passes = 1e30, best_lut = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        memcpy(a->pixels, base->pixels, size);
+        memcpy(b->pixels, base->pixels, size);
+
+        double t0 = now_seconds();
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) a->data[y][x].red = (uint8_t)curve[a->data[y][x].red];
+        }
+        bmp24_brightness(a, 20);
+        bmp24_negative(a);
+        bmp24_brightness(a, -35);
+        bmp24_negative(a);
+        double t1 = now_seconds();
+        t_lut lut;
+        lut_init(&lut, 3);
+        lut_remap(&lut, 0, curve);
+        lut_brightness(&lut, 20);
+        lut_negative(&lut);
+        lut_brightness(&lut, -35);
+        lut_negative(&lut);
+        bmp24_applyLUT(b, &lut);
+        double t2 = now_seconds();
+
+        if (t1 - t0 < best_passes) best_passes = t1 - t0;
+        if (t2 - t1 < best_lut) best_lut = t2 - t1;
+    }
+    print_result("5 separate passes", best_passes, mp, mp * 3.0);
+    print_result("compiled LUT (1 pass)", best_lut, mp, mp * 3.0);
+    int same = 1;
+    for (int y = 0; y < height; y++) {
+        if (memcmp(a->data[y], b->data[y], width * sizeof(t_rgb_pixel)) != 0) same = 0;
+    }
+    fprintf(report, "  speedup: %.1fx  %s\n", best_passes / best_lut, same ? "identical" : "MISMATCH");
+
+done:
+    bmp24_free(base);
+    bmp24_free(a);
+    bmp24_free(b);
+}
+
+// Same chain run filter by filter, then recorded and materialized as a pipeline
+static void bench_pipeline(int width, int height, int repeats) {
+    double mp = (double)width * height / 1e6;
+    t_bmp24 *base = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp24 *a = bmp24_loadImage(BENCH_FILE_24);
+    t_bmp24 *b = bmp24_loadImage(BENCH_FILE_24);
+    if (!base || !a || !b) {
+        fprintf(report, "  allocation failed\n");
+        goto done;
+    }
+    size_t size = base->stride * height;
+
+    double best_filters = 1e30, best_pipeline = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        memcpy(a->pixels, base->pixels, size);
+        memcpy(b->pixels, base->pixels, size);
+
+        double t0 = now_seconds();
+        bmp24_brightness(a, 20);
+        bmp24_negative(a);
+        bmp24_gaussianBlur(a);
+        bmp24_sharpen(a);
+        bmp24_brightness(a, -10);
+        double t1 = now_seconds();
+        run_pipeline_chain(b);
+        double t2 = now_seconds();
+
+        if (t1 - t0 < best_filters) best_filters = t1 - t0;
+        if (t2 - t1 < best_pipeline) best_pipeline = t2 - t1;
+    }
+    print_result("5 filters, one after the other", best_filters, mp, mp * 3.0);
+    print_result("pipeline (strips)", best_pipeline, mp, mp * 3.0);
+    int same = 1;
+    for (int y = 0; y < height; y++) {
+        if (memcmp(a->data[y], b->data[y], width * sizeof(t_rgb_pixel)) != 0) same = 0;
+    }
+    fprintf(report, "  speedup: %.1fx  %s\n", best_filters / best_pipeline, same ? "identical" : "MISMATCH");
+
+done:
+    bmp24_free(base);
+    bmp24_free(a);
+    bmp24_free(b);
+}
+
+// --- Suite: every public operation at several image sizes ---
+
+// Images shared by the suite operations. Filters run on img8 / img24, which
+// are restored from the pristine copies (untimed) before every run.
+typedef struct {
+    t_bmp8 *img8, *pristine8, *loaded8;
+    t_bmp24 *img24, *pristine24, *loaded24;
+} t_suite_state;
+
+typedef struct {
+    const char *name;
+    int depth;                       // 8 or 24: which image the operation works on
+    int restore;                     // Reset the image before each run
+    void (*run)(t_suite_state *s);
+} t_suite_op;
+
+typedef struct {
+    char name[40];
+    int width, height;
+    double megapixels, megabytes;
+    double best, median, mean;       // Seconds
+} t_suite_result;
+
+static t_suite_result *suite_results = NULL;
+static int suite_count = 0;
+
+static void s8_load(t_suite_state *s) { s->loaded8 = bmp8_loadImage(BENCH_FILE_8); }
+static void s8_map(t_suite_state *s) { s->loaded8 = bmp8_mapImage(BENCH_FILE_8); }
+static void s8_save(t_suite_state *s) { bmp8_saveImage(BENCH_FILE_OUT, s->img8); }
+static void s8_negative(t_suite_state *s) { bmp8_negative(s->img8); }
+static void s8_brightness(t_suite_state *s) { bmp8_brightness(s->img8, 40); }
+static void s8_threshold(t_suite_state *s) { bmp8_threshold(s->img8, 128); }
+static void s8_box(t_suite_state *s) { bmp8_boxBlur(s->img8); }
+static void s8_gaussian(t_suite_state *s) { bmp8_gaussianBlur(s->img8); }
+static void s8_outline(t_suite_state *s) { bmp8_outline(s->img8); }
+static void s8_emboss(t_suite_state *s) { bmp8_emboss(s->img8); }
+static void s8_sharpen(t_suite_state *s) { bmp8_sharpen(s->img8); }
+static void s8_box_radius(t_suite_state *s) { bmp8_boxBlurRadius(s->img8, 8); }
+static void s8_equalize(t_suite_state *s) { bmp8_equalize(s->img8); }
+static void s8_histogram(t_suite_state *s) { free(bmp8_computeHistogram(s->img8)); }
+static void s8_clahe(t_suite_state *s) { bmp8_clahe(s->img8, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_CLIP_LIMIT); }
+
+static void s24_load(t_suite_state *s) { s->loaded24 = bmp24_loadImage(BENCH_FILE_24); }
+static void s24_map(t_suite_state *s) { s->loaded24 = bmp24_mapImage(BENCH_FILE_24); }
+static void s24_save(t_suite_state *s) { bmp24_saveImage(BENCH_FILE_OUT, s->img24); }
+static void s24_negative(t_suite_state *s) { bmp24_negative(s->img24); }
+static void s24_grayscale(t_suite_state *s) { bmp24_grayscale(s->img24); }
+static void s24_brightness(t_suite_state *s) { bmp24_brightness(s->img24, 40); }
+static void s24_box(t_suite_state *s) { bmp24_boxBlur(s->img24); }
+static void s24_gaussian(t_suite_state *s) { bmp24_gaussianBlur(s->img24); }
+static void s24_outline(t_suite_state *s) { bmp24_outline(s->img24); }
+static void s24_emboss(t_suite_state *s) { bmp24_emboss(s->img24); }
+static void s24_sharpen(t_suite_state *s) { bmp24_sharpen(s->img24); }
+static void s24_box_radius(t_suite_state *s) { bmp24_boxBlurRadius(s->img24, 8); }
+static void s24_equalize(t_suite_state *s) { bmp24_equalize(s->img24); }
+static void s24_histograms(t_suite_state *s) { free(bmp24_computeHistograms(s->img24)); }
+static void s24_stats(t_suite_state *s) { free(bmp24_computeStats(s->img24)); }
+static void s24_clahe(t_suite_state *s) { bmp24_clahe(s->img24, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_CLIP_LIMIT); }
+
+static const t_suite_op suite_ops[] = {
+    {"bmp8_loadImage", 8, 0, s8_load},
+    {"bmp8_mapImage", 8, 0, s8_map},
+    {"bmp8_saveImage", 8, 0, s8_save},
+    {"bmp8_negative", 8, 1, s8_negative},
+    {"bmp8_brightness(+40)", 8, 1, s8_brightness},
+    {"bmp8_threshold(128)", 8, 1, s8_threshold},
+    {"bmp8_boxBlur", 8, 1, s8_box},
+    {"bmp8_gaussianBlur", 8, 1, s8_gaussian},
+    {"bmp8_outline", 8, 1, s8_outline},
+    {"bmp8_emboss", 8, 1, s8_emboss},
+    {"bmp8_sharpen", 8, 1, s8_sharpen},
+    {"bmp8_boxBlurRadius(8)", 8, 1, s8_box_radius},
+    {"bmp8_equalize", 8, 1, s8_equalize},
+    {"bmp8_computeHistogram", 8, 0, s8_histogram},
+    {"bmp8_clahe(8x8, 2.0)", 8, 1, s8_clahe},
+    {"bmp24_loadImage", 24, 0, s24_load},
+    {"bmp24_mapImage", 24, 0, s24_map},
+    {"bmp24_saveImage", 24, 0, s24_save},
+    {"bmp24_negative", 24, 1, s24_negative},
+    {"bmp24_grayscale", 24, 1, s24_grayscale},
+    {"bmp24_brightness(+40)", 24, 1, s24_brightness},
+    {"bmp24_boxBlur", 24, 1, s24_box},
+    {"bmp24_gaussianBlur", 24, 1, s24_gaussian},
+    {"bmp24_outline", 24, 1, s24_outline},
+    {"bmp24_emboss", 24, 1, s24_emboss},
+    {"bmp24_sharpen", 24, 1, s24_sharpen},
+    {"bmp24_boxBlurRadius(8)", 24, 1, s24_box_radius},
+    {"bmp24_equalize", 24, 1, s24_equalize},
+    {"bmp24_computeHistograms", 24, 0, s24_histograms},
+    {"bmp24_computeStats", 24, 0, s24_stats},
+    {"bmp24_clahe(8x8, 2.0)", 24, 1, s24_clahe},
+};
+#define NUM_SUITE_OPS (sizeof(suite_ops) / sizeof(suite_ops[0]))
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Runs one operation `warmup` times untimed, then `repeats` timed runs.
+// Restoring the image and freeing loaded images happen outside the timed region.
+static void suite_measure(const t_suite_op *op, t_suite_state *s, int warmup, int repeats, double *samples) {
+    for (int r = -warmup; r < repeats; r++) {
+        if (op->restore && op->depth == 8) memcpy(s->img8->data, s->pristine8->data, s->img8->dataSize);
+        if (op->restore && op->depth == 24) memcpy(s->img24->pixels, s->pristine24->pixels, s->img24->stride * s->img24->info.height);
+
+        double t0 = now_seconds();
+        op->run(s);
+        double t1 = now_seconds();
+        if (r >= 0) samples[r] = t1 - t0;
+
+        bmp8_free(s->loaded8);
+        bmp24_free(s->loaded24);
+        s->loaded8 = NULL;
+        s->loaded24 = NULL;
+    }
+}
+
+static void suite_record(const char *name, int width, int height, int channels, double *samples, int repeats) {
+    t_suite_result *grown = (t_suite_result *)realloc(suite_results, (suite_count + 1) * sizeof(t_suite_result));
+    if (!grown) return;
+    suite_results = grown;
+    t_suite_result *res = &suite_results[suite_count++];
+
+    qsort(samples, repeats, sizeof(double), compare_doubles);
+    double total = 0;
+    for (int r = 0; r < repeats; r++) total += samples[r];
+    snprintf(res->name, sizeof(res->name), "%s", name);
+    res->width = width;
+    res->height = height;
+    res->megapixels = (double)width * height / 1e6;
+    res->megabytes = res->megapixels * channels;
+    res->best = samples[0];
+    res->median = (repeats % 2) ? samples[repeats / 2] : 0.5 * (samples[repeats / 2 - 1] + samples[repeats / 2]);
+    res->mean = total / repeats;
+
+    fprintf(report, "  %-26s %9.2f ms (median %9.2f) %9.1f MP/s %7.2f GB/s\n",
+            res->name, res->best * 1e3, res->median * 1e3,
+            res->megapixels / res->best, res->megabytes / res->best / 1e3);
+}
+
+// Times every operation on synthetic 8-bit and 24-bit images of `megapixels`
+static void bench_suite(double megapixels, int warmup, int repeats) {
+    // Odd width so every row carries padding, in both depths
+    int width24 = (int)sqrt(megapixels * 1e6 * 4.0 / 3.0) | 1;
+    int height = (int)(megapixels * 1e6 / width24);
+    int width8 = width24;
+    if (height < 1) height = 1;
+
+    t_suite_state s = {0};
+    double *samples = (double *)malloc(repeats * sizeof(double));
+    s.img8 = make_synthetic_bmp8(width8, height);
+    s.pristine8 = make_synthetic_bmp8(width8, height);
+    int ok = samples && s.img8 && s.pristine8 && write_synthetic_bmp24(BENCH_FILE_24, width24, height);
+    if (ok) {
+        bmp8_saveImage(BENCH_FILE_8, s.pristine8);
+        s.img24 = bmp24_loadImage(BENCH_FILE_24);
+        s.pristine24 = bmp24_loadImage(BENCH_FILE_24);
+        ok = s.img24 && s.pristine24;
+    }
+    if (!ok) {
+        fprintf(report, "  %.1f MP: allocation failed\n", megapixels);
+        goto done;
+    }
+
+    fprintf(report, "%.1f MP (8-bit %d x %d, 24-bit %d x %d), %d threads, best of %d after %d warmup:\n",
+            megapixels, width8, height, width24, height, get_num_threads(), repeats, warmup);
+    for (size_t i = 0; i < NUM_SUITE_OPS; i++) {
+        const t_suite_op *op = &suite_ops[i];
+        suite_measure(op, &s, warmup, repeats, samples);
+        suite_record(op->name, op->depth == 8 ? width8 : width24, height, op->depth / 8, samples, repeats);
+    }
+
+done:
+    remove(BENCH_FILE_8);
+    remove(BENCH_FILE_24);
+    remove(BENCH_FILE_OUT);
+    bmp8_free(s.img8);
+    bmp8_free(s.pristine8);
+    bmp24_free(s.img24);
+    bmp24_free(s.pristine24);
+    free(samples);
+}
+
+// Machine-readable copy of the suite results, for comparing runs
+static void write_suite_json(const char *filename, int warmup, int repeats) {
+    FILE *out = strcmp(filename, "-") == 0 ? report : fopen(filename, "w");
+    if (!out) {
+        fprintf(report, "Cannot write %s\n", filename);
+        return;
+    }
+    fprintf(out, "{\n  \"threads\": %d,\n  \"simd\": \"%s\",\n  \"warmup\": %d,\n  \"repeats\": %d,\n  \"results\": [\n",
+            get_num_threads(), u8_simd_level(), warmup, repeats);
+    for (int i = 0; i < suite_count; i++) {
+        const t_suite_result *r = &suite_results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"width\": %d, \"height\": %d, \"megapixels\": %.3f, "
+                     "\"best_ms\": %.4f, \"median_ms\": %.4f, \"mean_ms\": %.4f, \"mp_per_s\": %.2f, \"gb_per_s\": %.4f}%s\n",
+                r->name, r->width, r->height, r->megapixels, r->best * 1e3, r->median * 1e3, r->mean * 1e3,
+                r->megapixels / r->best, r->megabytes / r->best / 1e3, (i + 1 < suite_count) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    if (out != report) fclose(out);
+}
+
+static void print_bench_usage(const char *program) {
+    fprintf(report, "Usage: %s [options]\n", program);
+    fprintf(report, "  --sizes LIST   comma-separated image sizes in megapixels (default 1,4,16; up to 200)\n");
+    fprintf(report, "  --repeats N    timed runs per operation (default 5)\n");
+    fprintf(report, "  --warmup N     untimed runs before timing (default 1)\n");
+    fprintf(report, "  --threads N    threads for the suite, and the maximum for the scaling test\n");
+    fprintf(report, "  --detail MP    image size for the implementation comparisons (default 16, 0 skips them)\n");
+    fprintf(report, "  --json FILE    also write the suite results as JSON (\"-\" for stdout)\n");
+}
+
+int main(int argc, char **argv) {
+    const char *sizes = "1,4,16";
+    const char *json = NULL;
+    int repeats = 5, warmup = 1, threads = 0;
+    double detail = 16.0;
+
+    bench_silence_stdout();
+    for (int i = 1; i < argc; i++) {
+        int has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--sizes") == 0 && has_value) sizes = argv[++i];
+        else if (strcmp(argv[i], "--repeats") == 0 && has_value) repeats = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && has_value) warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && has_value) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--detail") == 0 && has_value) detail = atof(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && has_value) json = argv[++i];
+        else {
+            print_bench_usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (repeats <= 0) repeats = 5;
+    if (warmup < 0) warmup = 0;
+    set_num_threads(threads);
+    int max_threads = get_num_threads();
+
+    initialize_kernels();
+
+    // Suite over every requested size
+    for (const char *p = sizes; *p;) {
+        char *end = NULL;
+        double megapixels = strtod(p, &end);
+        if (end == p) break;
+        if (megapixels > 0) bench_suite(megapixels, warmup, repeats);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    if (json) write_suite_json(json, warmup, repeats);
+
+    // Implementation comparisons at a single size
+    if (detail > 0) {
+        // Slightly off a multiple of 4 so every row carries padding
+        int width = (int)sqrt(detail * 1e6 * 4.0 / 3.0) | 1;
+        int height = (int)(detail * 1e6 / width);
+
+        fprintf(report, "\nImage: %d x %d (%.1f MP), best of %d\n", width, height, width * (double)height / 1e6, repeats);
+        if (!write_synthetic_bmp24(BENCH_FILE_24, width, height)) {
+            fprintf(report, "Failed to create synthetic image\n");
+            return 1;
+        }
+        bench_load24(width, height, repeats);
+        bench_lifecycle24(width, height, repeats);
+        fprintf(report, "8-bit point operations:\n");
+        bench_pointops8(width, height, repeats);
+        fprintf(report, "Point operation chain (24-bit):\n");
+        bench_lut_chain(width, height, repeats);
+        fprintf(report, "Filter chain as a pipeline (24-bit):\n");
+        bench_pipeline(width, height, repeats);
+        fprintf(report, "8-bit histogram:\n");
+        bench_histogram(width, height, repeats);
+        fprintf(report, "Gaussian blur and pipeline scaling:\n");
+        bench_threads(width, height, max_threads);
+        fprintf(report, "parallel_for dispatch:\n");
+        bench_dispatch(max_threads > 1 ? max_threads : 4, repeats);
+        set_num_threads(threads);
+        fprintf(report, "Separable Gaussian blur (1 MP, 8-bit):\n");
+        bench_separable();
+        fprintf(report, "Box blur of any radius (3 MP, 24-bit):\n");
+        bench_box_radius(repeats);
+        fprintf(report, "Fixed-point convolution (1 MP, 8-bit, 3x3 built-in kernels):\n");
+        bench_fixed_point();
+        fprintf(report, "In-place convolution (24-bit):\n");
+        bench_inplace(width, height, repeats);
+        fprintf(report, "24-bit vs 32-bit pixels:\n");
+        bench_pixels32(width, height, repeats);
+        fprintf(report, "Interleaved vs planar 24-bit:\n");
+        bench_planar(width, height, repeats);
+        fprintf(report, "Scratch arenas (24-bit, heap blocks per operation):\n");
+        bench_scratch(repeats);
+        fprintf(report, "Tiled convolution (32768 x 96, 24-bit):\n");
+        bench_tiles(repeats);
+        fprintf(report, "RGB/YUV conversion (3 MP):\n");
+        bench_yuv(repeats);
+        remove(BENCH_FILE_24);
+    }
+
+    free(suite_results);
+    cleanup_kernels();
+    return 0;
+}
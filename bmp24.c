@@ -1,33 +1,42 @@
 #include "bmp24.h"
+#include "convolution.h"
+#include "pixelops.h"
 
 // --- Allocation and Deallocation Functions ---
+size_t bmp24_rowStride(int width) {
+    return ((size_t)width * sizeof(t_rgb_pixel) + 3) & ~(size_t)3;
+}
+
 t_rgb_pixel **bmp24_allocateDataPixels(int width, int height) {
     if (width <= 0 || height <= 0) return NULL;
-    t_rgb_pixel **pixels = (t_rgb_pixel **)malloc(height * sizeof(t_rgb_pixel *));
+    // One extra slot past the last row keeps the raw allocation for bmp24_freeDataPixels
+    t_rgb_pixel **pixels = (t_rgb_pixel **)malloc((height + 1) * sizeof(t_rgb_pixel *));
     if (!pixels) {
         perror("Failed to allocate rows for pixel data");
         return NULL;
     }
+
+    // All rows live in a single buffer; the row table only points into it.
+    // calloc initializes to black, and large blocks come zeroed from the OS for free.
+    size_t stride = bmp24_rowStride(width);
+    uint8_t *raw = (uint8_t *)calloc(stride * height + BMP24_BUFFER_ALIGNMENT, 1);
+    if (!raw) {
+        perror("Failed to allocate pixel buffer");
+        free(pixels);
+        return NULL;
+    }
+    uint8_t *buffer = raw + (BMP24_BUFFER_ALIGNMENT - (uintptr_t)raw % BMP24_BUFFER_ALIGNMENT) % BMP24_BUFFER_ALIGNMENT;
+
     for (int i = 0; i < height; i++) {
-        pixels[i] = (t_rgb_pixel *)malloc(width * sizeof(t_rgb_pixel));
-        if (!pixels[i]) {
-            perror("Failed to allocate columns for pixel data");
-            // Free already allocated rows
-            for (int j = 0; j < i; j++) free(pixels[j]);
-            free(pixels);
-            return NULL;
-        }
-        // Initialize to black
-        memset(pixels[i], 0, width * sizeof(t_rgb_pixel));
+        pixels[i] = (t_rgb_pixel *)(buffer + i * stride);
     }
+    pixels[height] = (t_rgb_pixel *)raw;
     return pixels;
 }
 
 void bmp24_freeDataPixels(t_rgb_pixel **pixels, int height) {
     if (!pixels) return;
-    for (int i = 0; i < height; i++) {
-        free(pixels[i]);
-    }
+    free(pixels[height]); // The whole pixel buffer
     free(pixels);
 }
 
@@ -44,6 +53,8 @@ t_bmp24 *bmp24_allocate(int width, int height, int colorDepth) {
         free(img);
         return NULL;
     }
+    img->pixels = (uint8_t *)img->data[0];
+    img->stride = bmp24_rowStride(width);
 
     // Initialize header and info (sensible defaults for a new 24-bit image)
     img->header.type = BMP_TYPE_MAGIC_VALUE; // 'BM'
@@ -83,81 +94,104 @@ t_bmp24 *bmp24_allocate(int width, int height, int colorDepth) {
 
 void bmp24_free(t_bmp24 *img) {
     if (img) {
-        if (img->data) {
+        if (img->mapping) {
+            // Rows point into the mapping, only the row table is ours
+            free(img->data);
+            file_unmap(img->mapping, img->mappingSize);
+            img->mapping = NULL;
+        } else if (img->data) {
             bmp24_freeDataPixels(img->data, abs(img->info.height));
-            img->data = NULL;
         }
+        img->data = NULL;
         free(img);
     }
 }
 
 // --- Loading and Saving ---
 
-void bmp24_readPixelData(t_bmp24 *image, FILE *file) {
-    if (!image || !file || !image->data) return;
+// Images below this many bytes are reordered / filtered row by row on the calling thread
+#define BMP24_PARALLEL_MIN (1u << 20)
 
-    int width = image->info.width;
-    int height = abs(image->info.height); // Use absolute height for iteration
-    int original_height_sign = (image->info.height > 0) ? 1 : -1; // To know if top-down or bottom-up
+// Runs `rows` over [0, count) on the calling thread for small images, else with parallel_for
+static void bmp24_forRows(int count, size_t bytes, t_range_fn rows, void *ctx) {
+    if (bytes < BMP24_PARALLEL_MIN) {
+        rows(0, count, ctx);
+    } else {
+        parallel_for(0, count, rows, ctx);
+    }
+}
 
-    // BMP stores rows from bottom to top if height is positive.
-    // Top to bottom if height is negative.
-    // We will always store in our `data` array from top to bottom (row 0 is top row).
+typedef struct {
+    uint8_t *pixels;
+    size_t stride;
+    int width;
+    int height;
+} t_bmp24_rows_job;
+
+// Rows [begin, end) of a top-down file: B,G,R -> R,G,B
+static void bmp24_swizzleRows(int begin, int end, void *ctx) {
+    const t_bmp24_rows_job *job = (const t_bmp24_rows_job *)ctx;
+    for (int y = begin; y < end; y++) {
+        uint8_t *row = job->pixels + y * job->stride;
+        for (int x = 0; x < job->width; x++, row += 3) {
+            uint8_t b = row[0];
+            row[0] = row[2];
+            row[2] = b;
+        }
+    }
+}
 
-    // Calculate padding for each row
-    // Each row in file is padded to be a multiple of 4 bytes
-    int row_byte_width_unpadded = width * sizeof(t_pixel); // Using t_pixel (BGR) for file reading
-    int padding = (4 - (row_byte_width_unpadded % 4)) % 4;
+// Pairs of mirrored rows (top, height - 1 - top) for top in [begin, end) of a bottom-up file
+static void bmp24_flipRows(int begin, int end, void *ctx) {
+    const t_bmp24_rows_job *job = (const t_bmp24_rows_job *)ctx;
+    for (int top = begin; top < end; top++) {
+        uint8_t *a = job->pixels + top * job->stride;
+        uint8_t *b = job->pixels + (job->height - 1 - top) * job->stride;
+        for (int x = 0; x < job->width; x++, a += 3, b += 3) {
+            uint8_t a0 = a[0], a1 = a[1], a2 = a[2];
+            a[0] = b[2]; a[1] = b[1]; a[2] = b[0];
+            b[0] = a2; b[1] = a1; b[2] = a0; // Middle row (top == bottom) is simply swizzled
+        }
+    }
+}
 
-    // Seek to the beginning of pixel data
-    fseek(file, image->header.offset, SEEK_SET);
+// Turns pixel rows laid out as in the file (B,G,R, bottom-up if `bottom_up`)
+// into our top-down R,G,B layout, in place. Bottom-up images are flipped by
+// swapping mirrored rows while swizzling, so each byte is touched once.
+static void bmp24_fileRowsToRGB(uint8_t *pixels, size_t stride, int width, int height, int bottom_up) {
+    t_bmp24_rows_job job = {pixels, stride, width, height};
+    if (bottom_up) {
+        bmp24_forRows((height + 1) / 2, stride * height, bmp24_flipRows, &job);
+    } else {
+        bmp24_forRows(height, stride * height, bmp24_swizzleRows, &job);
+    }
+}
 
-    for (int y_file = 0; y_file < height; y_file++) {
-        // Determine which row in our memory buffer this corresponds to
-        int y_mem = (original_height_sign > 0) ? (height - 1 - y_file) : y_file;
+int bmp24_readPixelData(t_bmp24 *image, FILE *file) {
+    if (!image || !file || !image->pixels) return 1;
 
-        for (int x = 0; x < width; x++) {
-            t_pixel bgr_pixel; // Temporary to read BGR
-            if (fread(&bgr_pixel, sizeof(t_pixel), 1, file) != 1) {
-                perror("Error reading pixel data");
-                return;
-            }
-            // Convert BGR to RGB for our t_rgb_pixel structure
-            image->data[y_mem][x].red = bgr_pixel.red;     // PDF uses R,G,B order in t_pixel struct
-            image->data[y_mem][x].green = bgr_pixel.green; // but BMP file is B,G,R
-            image->data[y_mem][x].blue = bgr_pixel.blue;   // Re-check PDF section 2.2.2
-            // PDF section 2.2.2: t_pixel has red, green, blue
-            // PDF section 2.4.2 remarks: "Pixels are stored in BGR order... reverse order of color channels"
-            // So, when reading: file_blue -> our_blue, file_green -> our_green, file_red -> our_red
-            // IF t_pixel in header is BGR:
-            image->data[y_mem][x].red = bgr_pixel.red;     // file.blue  -> our.red
-            image->data[y_mem][x].green = bgr_pixel.green; // file.green -> our.green
-            image->data[y_mem][x].blue = bgr_pixel.blue;   // file.red   -> our.blue
-
-            // Let's assume t_pixel defined above is BGR (blue, green, red in memory)
-            // And t_rgb_pixel is R,G,B
-            // So we map:
-            // image->data[y_mem][x].red = bgr_pixel.red; // if bgr_pixel was (r,g,b)
-            // image->data[y_mem][x].green = bgr_pixel.green;
-            // image->data[y_mem][x].blue = bgr_pixel.blue;
-
-            // Let's use the actual t_pixel from PDF for file reading (uint8_t blue, green, red)
-            // And our internal t_rgb_pixel is (uint8_t red, green, blue)
-            t_pixel file_px; // This is (blue, green, red) as it's read from file
-            // rewind a bit
-            fseek(file, -sizeof(t_pixel), SEEK_CUR);
-            fread(&file_px, sizeof(t_pixel), 1, file);
-
-            image->data[y_mem][x].red = file_px.red;
-            image->data[y_mem][x].green = file_px.green;
-            image->data[y_mem][x].blue = file_px.blue;
+    int width = image->info.width;
+    int height = abs(image->info.height); // Use absolute height for iteration
 
-        }
-        // Skip padding bytes
-        if (padding > 0) {
-            fseek(file, padding, SEEK_CUR);
-        }
+    // BMP stores rows from bottom to top if height is positive.
+    // Top to bottom if height is negative.
+    // We always store in our buffer from top to bottom (row 0 is top row).
+
+    // Our buffer uses the same padded row size as the file, so the whole
+    // pixel array comes in with one fread and is then fixed up in place.
+    size_t total = image->stride * height;
+    size_t last_row_padding = image->stride - (size_t)width * sizeof(t_pixel);
+
+    // Seek to the beginning of pixel data. Only the pixel bytes are required;
+    // some writers drop the last row's padding
+    size_t got = (fseek(file, image->header.offset, SEEK_SET) == 0) ? fread(image->pixels, 1, total, file) : 0;
+    if (got < total - last_row_padding) {
+        fprintf(stderr, "Error reading pixel data: the file is truncated.\n");
+        return 1;
     }
+
+    bmp24_fileRowsToRGB(image->pixels, image->stride, width, height, image->info.height > 0);
+    return 0;
 }
 
 
@@ -176,6 +210,18 @@ void bmp24_writePixelData(t_bmp24 *image, FILE *file) {
     // Seek to the beginning of pixel data
     fseek(file, image->header.offset, SEEK_SET);
 
+    if (image->fileLayout) {
+        // Mapped rows never written to are still as in the file: copy them as they are
+        for (int y = 0; y < height; y++) {
+            if (fwrite(image->pixels + y * image->stride, 1, row_byte_width_unpadded, file) != (size_t)row_byte_width_unpadded ||
+                (padding > 0 && fwrite(pad_bytes, 1, padding, file) != (size_t)padding)) {
+                perror("Error writing pixel data");
+                return;
+            }
+        }
+        return;
+    }
+
     for (int y_file = 0; y_file < height; y_file++) {
         int y_mem = (original_height_sign > 0) ? (height - 1 - y_file) : y_file;
 
@@ -265,13 +311,107 @@ t_bmp24 *bmp24_loadImage(const char *filename) {
 
 
     // Read pixel data
-    bmp24_readPixelData(img, file);
+    if (bmp24_readPixelData(img, file) != 0) {
+        bmp24_free(img);
+        fclose(file);
+        return NULL;
+    }
 
     fclose(file);
     printf("24-bit image %s loaded successfully.\n", filename);
     return img;
 }
 
+t_bmp24 *bmp24_mapImage(const char *filename) {
+    size_t size = 0;
+    uint8_t *mapping = file_mapPrivate(filename, &size);
+    if (!mapping) return NULL;
+
+    t_bmp_header bmpHeader;
+    t_bmp_info bmpInfo;
+    if (size < sizeof(t_bmp_header) + sizeof(t_bmp_info)) {
+        fprintf(stderr, "Error reading BMP headers from %s\n", filename);
+        file_unmap(mapping, size);
+        return NULL;
+    }
+    memcpy(&bmpHeader, mapping, sizeof(t_bmp_header));
+    memcpy(&bmpInfo, mapping + sizeof(t_bmp_header), sizeof(t_bmp_info));
+
+    if (bmpHeader.type != BMP_TYPE_MAGIC_VALUE) {
+        fprintf(stderr, "%s is not a valid BMP file (signature: 0x%X).\n", filename, bmpHeader.type);
+        file_unmap(mapping, size);
+        return NULL;
+    }
+    if (bmpInfo.bits != DEFAULT_DEPTH_24BIT || bmpInfo.compression != 0 || bmpInfo.width <= 0 || bmpInfo.height == 0) {
+        fprintf(stderr, "%s is not an uncompressed 24-bit image.\n", filename);
+        file_unmap(mapping, size);
+        return NULL;
+    }
+
+    int width = bmpInfo.width;
+    int height = abs(bmpInfo.height);
+    size_t row_padded_size = bmp24_rowStride(width);
+    // Only the pixel bytes are required; some writers drop the last row's padding
+    if (bmpHeader.offset > size ||
+        size - bmpHeader.offset < row_padded_size * (height - 1) + (size_t)width * sizeof(t_pixel)) {
+        fprintf(stderr, "%s is truncated.\n", filename);
+        file_unmap(mapping, size);
+        return NULL;
+    }
+
+    t_bmp24 *img = (t_bmp24 *)calloc(1, sizeof(t_bmp24));
+    t_rgb_pixel **rows = (t_rgb_pixel **)malloc(height * sizeof(t_rgb_pixel *));
+    if (!img || !rows) {
+        perror("Failed to allocate mapped t_bmp24");
+        free(img);
+        free(rows);
+        file_unmap(mapping, size);
+        return NULL;
+    }
+    img->header = bmpHeader;
+    img->info = bmpInfo;
+    img->info.imagesize = row_padded_size * height;
+    img->header.size = img->header.offset + img->info.imagesize;
+    img->mapping = mapping;
+    img->mappingSize = size;
+    img->data = rows;
+
+    // The pixel array of the file becomes our buffer: same padded row size.
+    // The row and channel order are only fixed up by the first write.
+    img->pixels = mapping + bmpHeader.offset;
+    img->stride = row_padded_size;
+    img->fileLayout = 1;
+    for (int y = 0; y < height; y++) {
+        rows[y] = (t_rgb_pixel *)(img->pixels + y * img->stride);
+    }
+    return img;
+}
+
+int bmp24_makeWritable(t_bmp24 *img) {
+    if (!img || !img->pixels) return 1;
+    if (!img->fileLayout) return 0;
+
+    int width = img->info.width;
+    int height = abs(img->info.height);
+    size_t bytes = img->stride * height;
+    if (img->mappingSize - (size_t)(img->pixels - img->mapping) < bytes) {
+        // The last row has no padding in the file, but the filters sweep whole
+        // rows: move the pixels to a buffer of our own
+        t_rgb_pixel **rows = bmp24_allocateDataPixels(width, height);
+        if (!rows) return 1;
+        memcpy(rows[0], img->pixels, bytes - (img->stride - (size_t)width * sizeof(t_pixel)));
+        free(img->data);
+        file_unmap(img->mapping, img->mappingSize);
+        img->mapping = NULL;
+        img->mappingSize = 0;
+        img->data = rows;
+        img->pixels = (uint8_t *)rows[0];
+    }
+    bmp24_fileRowsToRGB(img->pixels, img->stride, width, height, img->info.height > 0);
+    img->fileLayout = 0;
+    return 0;
+}
+
 void bmp24_saveImage(const char *filename, t_bmp24 *img) {
     if (!img) {
         fprintf(stderr, "Error: Image is NULL in bmp24_saveImage.\n");
@@ -332,51 +472,48 @@ void bmp24_printInfo(t_bmp24 *img) {
 
 // --- Image Processing Functions (24-bit) ---
 void bmp24_negative(t_bmp24 *img) {
-    if (!img || !img->data) return;
+    if (!img || !img->data || bmp24_makeWritable(img) != 0) return;
     int height = abs(img->info.height);
-    int width = img->info.width;
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            img->data[y][x].red = 255 - img->data[y][x].red;
-            img->data[y][x].green = 255 - img->data[y][x].green;
-            img->data[y][x].blue = 255 - img->data[y][x].blue;
-        }
-    }
+    // Channels are independent: sweep the whole buffer (row padding included)
+    u8_negative(img->pixels, img->stride * height);
     printf("24-bit Negative filter applied.\n");
 }
 
+void bmp24_grayscaleRow(t_rgb_pixel *row, int width) {
+    for (int x = 0; x < width; x++) {
+        // Average method for grayscale
+        uint8_t gray = (uint8_t)roundf(
+                (row[x].red + row[x].green + row[x].blue) / 3.0f
+        );
+        row[x].red = gray;
+        row[x].green = gray;
+        row[x].blue = gray;
+    }
+}
+
+static void bmp24_grayscaleRows(int begin, int end, void *ctx) {
+    const t_bmp24_rows_job *job = (const t_bmp24_rows_job *)ctx;
+    for (int y = begin; y < end; y++) {
+        bmp24_grayscaleRow((t_rgb_pixel *)(job->pixels + y * job->stride), job->width);
+    }
+}
+
 void bmp24_grayscale(t_bmp24 *img) {
-    if (!img || !img->data) return;
+    if (!img || !img->data || bmp24_makeWritable(img) != 0) return;
     int height = abs(img->info.height);
     int width = img->info.width;
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            // Average method for grayscale
-            uint8_t gray = (uint8_t)roundf(
-                    (img->data[y][x].red + img->data[y][x].green + img->data[y][x].blue) / 3.0f
-            );
-            img->data[y][x].red = gray;
-            img->data[y][x].green = gray;
-            img->data[y][x].blue = gray;
-        }
-    }
+    t_bmp24_rows_job job = {img->pixels, img->stride, width, height};
+    bmp24_forRows(height, img->stride * height, bmp24_grayscaleRows, &job);
     printf("24-bit Grayscale filter applied.\n");
 }
 
 void bmp24_brightness(t_bmp24 *img, int value) {
-    if (!img || !img->data) return;
+    if (!img || !img->data || bmp24_makeWritable(img) != 0) return;
     int height = abs(img->info.height);
-    int width = img->info.width;
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            img->data[y][x].red = (uint8_t)clamp_int((int)img->data[y][x].red + value, 0, 255);
-            img->data[y][x].green = (uint8_t)clamp_int((int)img->data[y][x].green + value, 0, 255);
-            img->data[y][x].blue = (uint8_t)clamp_int((int)img->data[y][x].blue + value, 0, 255);
-        }
-    }
+    u8_brightness(img->pixels, img->stride * height, value);
     printf("24-bit Brightness filter applied (value: %d).\n", value);
 }
 
@@ -418,34 +555,26 @@ void bmp24_apply_convolution_filter(t_bmp24 *img, float **kernel, int kernelSize
         fprintf(stderr, "Error: Invalid arguments for %s.\n", filterName);
         return;
     }
+    if (bmp24_makeWritable(img) != 0) return;
 
-    int width = img->info.width;
-    int height = abs(img->info.height);
+    // Same result as calling bmp24_convolution_pixel on every interior pixel with a copy
+    // of the image as temp_data, in parallel row bands that only keep a few original rows
+    convolve_inplace_u8(img->pixels, img->info.width, abs(img->info.height), img->stride,
+                        sizeof(t_rgb_pixel), kernel, kernelSize);
+    printf("24-bit %s filter applied.\n", filterName);
+}
 
-    // Create a temporary copy of pixel data to read from
-    t_rgb_pixel **temp_data = bmp24_allocateDataPixels(width, height);
-    if (!temp_data) {
-        perror("Error allocating temp data for convolution");
+void bmp24_applySeparableFilter(t_bmp24 *img, const float *col, const float *row, int kernelSize) {
+    if (!img || !img->data || !col || !row || kernelSize <= 0 || kernelSize % 2 == 0) {
+        fprintf(stderr, "Error: Invalid arguments for bmp24_applySeparableFilter.\n");
         return;
     }
-    for(int y=0; y<height; ++y) {
-        memcpy(temp_data[y], img->data[y], width * sizeof(t_rgb_pixel));
-    }
+    if (bmp24_makeWritable(img) != 0) return;
 
-    int n = kernelSize / 2;
-
-    // Iterate through pixels, excluding borders
-    for (int y = n; y < height - n; y++) {
-        for (int x = n; x < width - n; x++) {
-            img->data[y][x] = bmp24_convolution_pixel(img, x, y, kernel, kernelSize, temp_data);
-        }
-    }
-
-    bmp24_freeDataPixels(temp_data, height);
-    printf("24-bit %s filter applied.\n", filterName);
+    convolve_separable_inplace_u8(img->pixels, img->info.width, abs(img->info.height), img->stride,
+                                  sizeof(t_rgb_pixel), col, row, kernelSize);
 }
 
-
 void bmp24_boxBlur(t_bmp24 *img) {
     bmp24_apply_convolution_filter(img, BOX_BLUR_KERNEL, KERNEL_SIZE_3x3, "Box Blur");
 }
@@ -466,3 +595,18 @@ void bmp24_sharpen(t_bmp24 *img) {
     bmp24_apply_convolution_filter(img, SHARPEN_KERNEL, KERNEL_SIZE_3x3, "Sharpen");
 }
 
+void bmp24_boxBlurRadius(t_bmp24 *img, int radius) {
+    if (!img || !img->data || radius <= 0 || radius > BOX_MAX_RADIUS) {
+        fprintf(stderr, "Error: Invalid arguments for bmp24_boxBlurRadius.\n");
+        return;
+    }
+    if (img->info.width <= 2 * radius || abs(img->info.height) <= 2 * radius) {
+        fprintf(stderr, "Error: Box blur radius %d does not fit the image.\n", radius);
+        return;
+    }
+    if (bmp24_makeWritable(img) != 0) return;
+
+    convolve_box_inplace_u8(img->pixels, img->info.width, abs(img->info.height), img->stride,
+                            sizeof(t_rgb_pixel), radius);
+    printf("24-bit Box Blur filter applied (radius: %d).\n", radius);
+}
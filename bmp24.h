@@ -62,21 +62,48 @@ typedef struct {
     // int height; (use info.height)
     // int colorDepth; (use info.bits)
 
-    t_rgb_pixel **data;      // Pixel data (2D array of pixels)
+    t_rgb_pixel **data;      // Row view into `pixels` (data[y] starts at pixels + y * stride), kept for compatibility.
+                             // While fileLayout is set the rows are still B,G,R and possibly
+                             // bottom-up: call bmp24_makeWritable before indexing data[y][x]
+    uint8_t *pixels;         // Contiguous top-down pixel buffer, R,G,B per pixel (once fileLayout is 0)
+    size_t stride;           // Bytes between the starts of two rows (BMP row size, multiple of 4)
+
+    uint8_t *mapping;        // File mapping the rows live in (bmp24_mapImage), NULL when rows are malloc'd
+    size_t mappingSize;      // Length of the mapping in bytes
+    int fileLayout;          // Mapped image not written to yet: rows are still as in the file
+                             // (B,G,R, and bottom-up when info.height > 0), which `data` and
+                             // `pixels` show as they are until bmp24_makeWritable
 } t_bmp24;
 
 
+// Alignment of the contiguous pixel buffer (one cache line)
+#define BMP24_BUFFER_ALIGNMENT 64
+
 // --- Allocation and Deallocation Functions ---
+// Bytes per row of pixel data: width * 3 rounded up to a multiple of 4, like a BMP row
+size_t bmp24_rowStride(int width);
+// Allocates one aligned, zeroed buffer of height rows (bmp24_rowStride bytes each)
+// and a row table into it: rows[0] is the start of the buffer.
 t_rgb_pixel **bmp24_allocateDataPixels(int width, int height);
 void bmp24_freeDataPixels(t_rgb_pixel **pixels, int height);
 t_bmp24 *bmp24_allocate(int width, int height, int colorDepth);
 void bmp24_free(t_bmp24 *img);
 
 // --- Loading and Saving 24-bit Images ---
-void bmp24_readPixelData(t_bmp24 *image, FILE *file); // Reads all pixel data
+int bmp24_readPixelData(t_bmp24 *image, FILE *file); // Reads all pixel data, 1 if the file is truncated
 void bmp24_writePixelData(t_bmp24 *image, FILE *file); // Writes all pixel data
 
 t_bmp24 *bmp24_loadImage(const char *filename);
+// Maps the file privately and exposes its rows in place instead of copying them.
+// Nothing is touched up front: the rows keep the file layout (fileLayout) until
+// the first write, which swizzles BGR -> RGB and flips them inside the mapping,
+// so the file itself is never modified.
+t_bmp24 *bmp24_mapImage(const char *filename);
+
+// Converts the rows of a mapped image to the top-down R,G,B layout if they are
+// still as in the file. Everything that writes the pixels, or reads them in
+// that layout, calls it first. Returns 0 on success.
+int bmp24_makeWritable(t_bmp24 *img);
 void bmp24_saveImage(const char *filename, t_bmp24 *img);
 void bmp24_printInfo(t_bmp24 *img);
 
@@ -84,11 +111,17 @@ void bmp24_printInfo(t_bmp24 *img);
 // --- Image Processing Functions (24-bit) ---
 void bmp24_negative(t_bmp24 *img);
 void bmp24_grayscale(t_bmp24 *img);
+void bmp24_grayscaleRow(t_rgb_pixel *row, int width); // Same conversion on one row of pixels
 void bmp24_brightness(t_bmp24 *img, int value);
 
 // Convolution for a single pixel (returns new pixel value)
 t_rgb_pixel bmp24_convolution_pixel(t_bmp24 *img, int x, int y, float **kernel, int kernelSize, t_rgb_pixel **temp_data);
 
+// Applies a separable filter given as kernel[ky][kx] = col[ky] * row[kx] (kernelSize odd),
+// as a horizontal then a vertical pass. Kernels detected as separable take this path
+// automatically in the filters below.
+void bmp24_applySeparableFilter(t_bmp24 *img, const float *col, const float *row, int kernelSize);
+
 // Functions to apply filters by calling bmp24_convolution_pixel for each pixel
 void bmp24_boxBlur(t_bmp24 *img);
 void bmp24_gaussianBlur(t_bmp24 *img);
@@ -96,6 +129,9 @@ void bmp24_outline(t_bmp24 *img);
 void bmp24_emboss(t_bmp24 *img);
 void bmp24_sharpen(t_bmp24 *img);
 
+// Box blur over a (2 * radius + 1)^2 window in O(1) per pixel (running sums)
+void bmp24_boxBlurRadius(t_bmp24 *img, int radius);
+
 
 #endif // BMP24_H
 
@@ -0,0 +1,398 @@
+#include "bmp32.h"
+#include "convolution.h"
+#include "pixelops.h"
+
+// Masks of a BI_RGB file: B, G, R, then the fourth byte (kept as alpha)
+static const uint32_t BMP32_DEFAULT_MASKS[4] = {0x00FF0000u, 0x0000FF00u, 0x000000FFu, 0xFF000000u};
+
+// --- Allocation and Deallocation Functions ---
+
+t_bmp32 *bmp32_allocate(int width, int height) {
+    if (width <= 0 || height <= 0) return NULL;
+    t_bmp32 *img = (t_bmp32 *)calloc(1, sizeof(t_bmp32));
+    // One extra slot past the last row keeps the raw allocation for bmp32_free
+    t_rgba_pixel **rows = (t_rgba_pixel **)malloc((height + 1) * sizeof(t_rgba_pixel *));
+    size_t stride = (size_t)width * sizeof(t_rgba_pixel);
+    uint8_t *raw = (uint8_t *)calloc(stride * height + BMP32_BUFFER_ALIGNMENT, 1);
+    if (!img || !rows || !raw) {
+        perror("Failed to allocate t_bmp32");
+        free(img);
+        free(rows);
+        free(raw);
+        return NULL;
+    }
+    uint8_t *buffer = raw + (BMP32_BUFFER_ALIGNMENT - (uintptr_t)raw % BMP32_BUFFER_ALIGNMENT) % BMP32_BUFFER_ALIGNMENT;
+    for (int y = 0; y < height; y++) {
+        rows[y] = (t_rgba_pixel *)(buffer + y * stride);
+    }
+    rows[height] = (t_rgba_pixel *)raw;
+
+    img->data = rows;
+    img->pixels = buffer;
+    img->stride = stride;
+    memcpy(img->masks, BMP32_DEFAULT_MASKS, sizeof(img->masks));
+
+    img->header.type = BMP_TYPE_MAGIC_VALUE;
+    img->header.offset = DEFAULT_HEADER_SIZE_VALUE + DEFAULT_INFO_SIZE_VALUE;
+    img->info.size = DEFAULT_INFO_SIZE_VALUE;
+    img->info.width = width;
+    img->info.height = height;
+    img->info.planes = 1;
+    img->info.bits = 32;
+    img->info.compression = BMP32_COMPRESSION_RGB;
+    img->info.imagesize = (uint32_t)(stride * height);
+    img->header.size = img->header.offset + img->info.imagesize;
+    return img;
+}
+
+void bmp32_free(t_bmp32 *img) {
+    if (!img) return;
+    if (img->data) {
+        free(img->data[abs(img->info.height)]); // The whole pixel buffer
+        free(img->data);
+    }
+    free(img->extraHeader);
+    free(img);
+}
+
+// --- Loading and Saving ---
+
+// Byte of the pixel a mask selects: 0..3, -1 for an empty mask, -2 if the mask
+// is not a whole byte
+static int bmp32_maskByte(uint32_t mask) {
+    if (mask == 0) return -1;
+    for (int b = 0; b < 4; b++) {
+        if (mask == 0xFFu << (8 * b)) return b;
+    }
+    return -2;
+}
+
+// Byte of each channel (R, G, B, A) in a file pixel. Returns 0, or 1 if the
+// masks are not distinct whole bytes (alpha may be missing: pos[3] is then -1).
+static int bmp32_channelBytes(const uint32_t masks[4], int pos[4]) {
+    int used = 0;
+    for (int c = 0; c < 4; c++) {
+        pos[c] = bmp32_maskByte(masks[c]);
+        if (pos[c] == -1 && c == 3) continue;
+        if (pos[c] < 0 || (used & (1 << pos[c]))) return 1;
+        used |= 1 << pos[c];
+    }
+    return 0;
+}
+
+// Images below this many bytes are reordered / filtered on the calling thread
+#define BMP32_PARALLEL_MIN (1u << 20)
+
+static void bmp32_forRows(int count, size_t bytes, t_range_fn rows, void *ctx) {
+    if (bytes < BMP32_PARALLEL_MIN) {
+        rows(0, count, ctx);
+    } else {
+        parallel_for(0, count, rows, ctx);
+    }
+}
+
+typedef struct {
+    uint8_t *pixels;
+    size_t stride;
+    int width;
+    int height;
+    const int *pos;     // File byte of R, G, B, A in each pixel (-1: no alpha)
+} t_bmp32_rows_job;
+
+// Rows [begin, end) of a top-down file
+static void bmp32_reorderRows(int begin, int end, void *ctx) {
+    const t_bmp32_rows_job *job = (const t_bmp32_rows_job *)ctx;
+    const int *pos = job->pos;
+    for (int y = begin; y < end; y++) {
+        uint8_t *p = job->pixels + y * job->stride;
+        for (int x = 0; x < job->width; x++, p += 4) {
+            uint8_t q[4];
+            memcpy(q, p, 4);
+            p[0] = q[pos[0]]; p[1] = q[pos[1]]; p[2] = q[pos[2]]; p[3] = (pos[3] >= 0) ? q[pos[3]] : 255;
+        }
+    }
+}
+
+// Pairs of mirrored rows (top, height - 1 - top) for top in [begin, end) of a bottom-up file
+static void bmp32_flipRows(int begin, int end, void *ctx) {
+    const t_bmp32_rows_job *job = (const t_bmp32_rows_job *)ctx;
+    const int *pos = job->pos;
+    for (int top = begin; top < end; top++) {
+        uint8_t *a = job->pixels + top * job->stride;
+        uint8_t *b = job->pixels + (job->height - 1 - top) * job->stride;
+        for (int x = 0; x < job->width; x++, a += 4, b += 4) {
+            uint8_t pa[4], pb[4];
+            memcpy(pa, a, 4);
+            memcpy(pb, b, 4); // Same pixel as pa on the middle row (top == bottom)
+            a[0] = pb[pos[0]]; a[1] = pb[pos[1]]; a[2] = pb[pos[2]]; a[3] = (pos[3] >= 0) ? pb[pos[3]] : 255;
+            b[0] = pa[pos[0]]; b[1] = pa[pos[1]]; b[2] = pa[pos[2]]; b[3] = (pos[3] >= 0) ? pa[pos[3]] : 255;
+        }
+    }
+}
+
+// Turns rows laid out as in the file (bytes in mask order, bottom-up if
+// `bottom_up`) into our top-down R,G,B,A layout, in place. Like
+// bmp24_fileRowsToRGB, mirrored rows are swapped while reordering.
+static void bmp32_fileRowsToRGBA(uint8_t *pixels, size_t stride, int width, int height, int bottom_up,
+                                 const int pos[4]) {
+    t_bmp32_rows_job job = {pixels, stride, width, height, pos};
+    if (bottom_up) {
+        bmp32_forRows((height + 1) / 2, stride * height, bmp32_flipRows, &job);
+    } else {
+        bmp32_forRows(height, stride * height, bmp32_reorderRows, &job);
+    }
+}
+
+t_bmp32 *bmp32_loadImage(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        perror("Error opening file for reading");
+        return NULL;
+    }
+
+    t_bmp_header bmpHeader;
+    t_bmp_info bmpInfo;
+    if (fread(&bmpHeader, sizeof(t_bmp_header), 1, file) != 1 || fread(&bmpInfo, sizeof(t_bmp_info), 1, file) != 1) {
+        fprintf(stderr, "Error reading BMP headers from %s\n", filename);
+        fclose(file);
+        return NULL;
+    }
+    if (bmpHeader.type != BMP_TYPE_MAGIC_VALUE || bmpInfo.size < DEFAULT_INFO_SIZE_VALUE) {
+        fprintf(stderr, "%s is not a valid BMP file.\n", filename);
+        fclose(file);
+        return NULL;
+    }
+    if (bmpInfo.bits != 32) {
+        fprintf(stderr, "%s is not a 32-bit image (depth: %d bits).\n", filename, bmpInfo.bits);
+        fclose(file);
+        return NULL;
+    }
+    if (bmpInfo.compression != BMP32_COMPRESSION_RGB && bmpInfo.compression != BMP32_COMPRESSION_BITFIELDS &&
+        bmpInfo.compression != BMP32_COMPRESSION_ALPHABITFIELDS) {
+        fprintf(stderr, "%s uses compression, which is not supported.\n", filename);
+        fclose(file);
+        return NULL;
+    }
+    if (bmpInfo.width <= 0 || bmpInfo.height == 0 || bmpInfo.height == INT32_MIN ||
+        bmpHeader.offset < sizeof(t_bmp_header) + sizeof(t_bmp_info)) {
+        fprintf(stderr, "%s has an invalid header.\n", filename);
+        fclose(file);
+        return NULL;
+    }
+
+    int width = bmpInfo.width;
+    int height = abs(bmpInfo.height);
+    t_bmp32 *img = bmp32_allocate(width, height);
+    if (!img) {
+        fclose(file);
+        return NULL;
+    }
+    img->header = bmpHeader;
+    img->info = bmpInfo;
+    img->info.imagesize = (uint32_t)(img->stride * height);
+    img->header.size = img->header.offset + img->info.imagesize;
+
+    // Everything up to the pixels is kept; the masks sit at its start, either as the
+    // end of a V3+ info header or right after a 40-byte one
+    img->extraSize = bmpHeader.offset - sizeof(t_bmp_header) - sizeof(t_bmp_info);
+    if (img->extraSize > 0) {
+        img->extraHeader = (uint8_t *)malloc(img->extraSize);
+        if (!img->extraHeader || fread(img->extraHeader, 1, img->extraSize, file) != img->extraSize) {
+            fprintf(stderr, "%s: truncated headers.\n", filename);
+            goto fail;
+        }
+    }
+    if (bmpInfo.compression != BMP32_COMPRESSION_RGB) {
+        int with_alpha = bmpInfo.compression == BMP32_COMPRESSION_ALPHABITFIELDS || bmpInfo.size >= 56;
+        size_t mask_bytes = (with_alpha ? 4 : 3) * sizeof(uint32_t);
+        if (img->extraSize < mask_bytes) {
+            fprintf(stderr, "%s: missing channel masks.\n", filename);
+            goto fail;
+        }
+        memset(img->masks, 0, sizeof(img->masks));
+        memcpy(img->masks, img->extraHeader, mask_bytes);
+    }
+    int pos[4];
+    if (bmp32_channelBytes(img->masks, pos) != 0) {
+        fprintf(stderr, "%s: only channel masks of whole bytes are supported.\n", filename);
+        goto fail;
+    }
+
+    // 32-bit rows have no padding: one read for the whole pixel array, then the
+    // channels are put in R,G,B,A order in place
+    size_t total = img->stride * height;
+    if (fseek(file, bmpHeader.offset, SEEK_SET) != 0 || fread(img->pixels, 1, total, file) != total) {
+        fprintf(stderr, "%s is truncated.\n", filename);
+        goto fail;
+    }
+    bmp32_fileRowsToRGBA(img->pixels, img->stride, width, height, bmpInfo.height > 0, pos);
+
+    fclose(file);
+    printf("32-bit image %s loaded successfully.\n", filename);
+    return img;
+
+fail:
+    bmp32_free(img);
+    fclose(file);
+    return NULL;
+}
+
+void bmp32_saveImage(const char *filename, t_bmp32 *img) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Image is NULL in bmp32_saveImage.\n");
+        return;
+    }
+    int pos[4];
+    if (bmp32_channelBytes(img->masks, pos) != 0) {
+        fprintf(stderr, "Error: Unsupported channel masks in bmp32_saveImage.\n");
+        return;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        perror("Error opening file for writing");
+        return;
+    }
+
+    int width = img->info.width;
+    int height = abs(img->info.height);
+    // The sizes are written from copies of the headers, the image is left as it is
+    t_bmp_header header = img->header;
+    t_bmp_info info = img->info;
+    header.offset = (uint32_t)(sizeof(t_bmp_header) + sizeof(t_bmp_info) + img->extraSize);
+    info.imagesize = (uint32_t)(img->stride * height);
+    header.size = header.offset + info.imagesize;
+
+    uint8_t *row = (uint8_t *)malloc(img->stride);
+    int ok = row && fwrite(&header, sizeof(t_bmp_header), 1, file) == 1 &&
+             fwrite(&info, sizeof(t_bmp_info), 1, file) == 1 &&
+             (img->extraSize == 0 || fwrite(img->extraHeader, 1, img->extraSize, file) == img->extraSize);
+
+    // Rows go out in file order, channels back in mask order (bytes no mask covers are 0)
+    for (int y_file = 0; ok && y_file < height; y_file++) {
+        int y_mem = (img->info.height > 0) ? height - 1 - y_file : y_file;
+        const uint8_t *src = img->pixels + (size_t)y_mem * img->stride;
+        memset(row, 0, img->stride);
+        uint8_t *dst = row;
+        for (int x = 0; x < width; x++, src += 4, dst += 4) {
+            dst[pos[0]] = src[0];
+            dst[pos[1]] = src[1];
+            dst[pos[2]] = src[2];
+            if (pos[3] >= 0) dst[pos[3]] = src[3];
+        }
+        ok = fwrite(row, 1, img->stride, file) == img->stride;
+    }
+    free(row);
+    if (!ok) {
+        perror("Error writing 32-bit image");
+        fclose(file);
+        return;
+    }
+
+    fclose(file);
+    printf("32-bit image saved successfully as %s.\n", filename);
+}
+
+void bmp32_printInfo(t_bmp32 *img) {
+    if (!img) {
+        printf("Image Info (32-bit): NULL image\n");
+        return;
+    }
+    printf("Image Info (32-bit):\n");
+    printf("  Width: %d pixels\n", img->info.width);
+    printf("  Height: %d pixels\n", img->info.height);
+    printf("  Info Header Size: %u\n", img->info.size);
+    printf("  Compression: %u\n", img->info.compression);
+    printf("  Masks: R 0x%08X G 0x%08X B 0x%08X A 0x%08X\n", img->masks[0], img->masks[1], img->masks[2], img->masks[3]);
+    printf("  Image Size (raw data): %u bytes\n", img->info.imagesize);
+}
+
+// --- Image Processing Functions (32-bit) ---
+void bmp32_negative(t_bmp32 *img) {
+    if (!img || !img->data) return;
+    // Rows are unpadded: sweep the whole buffer with the alpha lane masked out
+    rgba_negative(img->pixels, img->stride * abs(img->info.height));
+    printf("32-bit Negative filter applied.\n");
+}
+
+void bmp32_grayscaleRow(t_rgba_pixel *row, int width) {
+    for (int x = 0; x < width; x++) {
+        uint8_t gray = (uint8_t)roundf((row[x].red + row[x].green + row[x].blue) / 3.0f);
+        row[x].red = gray;
+        row[x].green = gray;
+        row[x].blue = gray;
+    }
+}
+
+static void bmp32_grayscaleRows(int begin, int end, void *ctx) {
+    const t_bmp32_rows_job *job = (const t_bmp32_rows_job *)ctx;
+    for (int y = begin; y < end; y++) {
+        bmp32_grayscaleRow((t_rgba_pixel *)(job->pixels + y * job->stride), job->width);
+    }
+}
+
+void bmp32_grayscale(t_bmp32 *img) {
+    if (!img || !img->data) return;
+    int height = abs(img->info.height);
+    t_bmp32_rows_job job = {img->pixels, img->stride, img->info.width, height, NULL};
+    bmp32_forRows(height, img->stride * height, bmp32_grayscaleRows, &job);
+    printf("32-bit Grayscale filter applied.\n");
+}
+
+void bmp32_brightness(t_bmp32 *img, int value) {
+    if (!img || !img->data) return;
+    rgba_brightness(img->pixels, img->stride * abs(img->info.height), value);
+    printf("32-bit Brightness filter applied (value: %d).\n", value);
+}
+
+static void bmp32_apply_convolution_filter(t_bmp32 *img, float **kernel, int kernelSize, const char *filterName) {
+    if (!img || !img->data || !kernel || kernelSize <= 0 || kernelSize % 2 == 0) {
+        fprintf(stderr, "Error: Invalid arguments for %s.\n", filterName);
+        return;
+    }
+
+    convolve_inplace_u8(img->pixels, img->info.width, abs(img->info.height), img->stride,
+                        sizeof(t_rgba_pixel), kernel, kernelSize);
+    printf("32-bit %s filter applied.\n", filterName);
+}
+
+void bmp32_applySeparableFilter(t_bmp32 *img, const float *col, const float *row, int kernelSize) {
+    if (!img || !img->data || !col || !row || kernelSize <= 0 || kernelSize % 2 == 0) {
+        fprintf(stderr, "Error: Invalid arguments for bmp32_applySeparableFilter.\n");
+        return;
+    }
+
+    convolve_separable_inplace_u8(img->pixels, img->info.width, abs(img->info.height), img->stride,
+                                  sizeof(t_rgba_pixel), col, row, kernelSize);
+}
+
+void bmp32_boxBlur(t_bmp32 *img) {
+    bmp32_apply_convolution_filter(img, BOX_BLUR_KERNEL, KERNEL_SIZE_3x3, "Box Blur");
+}
+
+void bmp32_gaussianBlur(t_bmp32 *img) {
+    bmp32_apply_convolution_filter(img, GAUSSIAN_BLUR_KERNEL, KERNEL_SIZE_3x3, "Gaussian Blur");
+}
+
+void bmp32_outline(t_bmp32 *img) {
+    bmp32_apply_convolution_filter(img, OUTLINE_KERNEL, KERNEL_SIZE_3x3, "Outline");
+}
+
+void bmp32_emboss(t_bmp32 *img) {
+    bmp32_apply_convolution_filter(img, EMBOSS_KERNEL, KERNEL_SIZE_3x3, "Emboss");
+}
+
+void bmp32_sharpen(t_bmp32 *img) {
+    bmp32_apply_convolution_filter(img, SHARPEN_KERNEL, KERNEL_SIZE_3x3, "Sharpen");
+}
+
+void bmp32_boxBlurRadius(t_bmp32 *img, int radius) {
+    if (!img || !img->data || radius <= 0) {
+        fprintf(stderr, "Error: Invalid arguments for bmp32_boxBlurRadius.\n");
+        return;
+    }
+
+    convolve_box_inplace_u8(img->pixels, img->info.width, abs(img->info.height), img->stride,
+                            sizeof(t_rgba_pixel), radius);
+    printf("32-bit Box Blur filter applied (radius: %d).\n", radius);
+}
@@ -0,0 +1,70 @@
+#ifndef BMP32_H
+#define BMP32_H
+
+#include "bmp24.h" // For t_bmp_header, t_bmp_info and the shared constants
+
+// 32-bit images: BI_RGB files (B, G, R and a fourth byte) and BI_BITFIELDS /
+// BI_ALPHABITFIELDS files whose masks are whole bytes, in any order.
+//
+// Pixels are kept as 4-byte R, G, B, A in one aligned top-down buffer, so a
+// pixel never straddles two words and rows need no padding. The filters work on
+// R, G and B like their 24-bit counterparts and leave alpha as it is.
+
+#define BMP32_COMPRESSION_RGB 0
+#define BMP32_COMPRESSION_BITFIELDS 3
+#define BMP32_COMPRESSION_ALPHABITFIELDS 6
+
+typedef struct {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint8_t alpha;
+} t_rgba_pixel;
+
+typedef struct {
+    t_bmp_header header;    // File header
+    t_bmp_info info;        // Info header (first 40 bytes, whatever its size)
+
+    uint32_t masks[4];      // Red, green, blue and alpha masks of the file (no alpha mask: read as opaque)
+    uint8_t *extraHeader;   // File bytes between the 40-byte info header and the pixels
+    size_t extraSize;       // (masks, V4/V5 fields), written back as they are
+
+    t_rgba_pixel **data;    // Row view into `pixels` (data[y] starts at pixels + y * stride)
+    uint8_t *pixels;        // Contiguous top-down pixel buffer, R,G,B,A per pixel
+    size_t stride;          // width * 4
+} t_bmp32;
+
+// Alignment of the contiguous pixel buffer (one cache line)
+#define BMP32_BUFFER_ALIGNMENT 64
+
+// --- Allocation and Deallocation Functions ---
+// New BI_RGB image (B, G, R, A in the file), pixels zeroed
+t_bmp32 *bmp32_allocate(int width, int height);
+void bmp32_free(t_bmp32 *img);
+
+// --- Loading and Saving 32-bit Images ---
+// The pixels are read with one fread and reordered in place. Returns NULL on error.
+t_bmp32 *bmp32_loadImage(const char *filename);
+// Writes the headers as loaded and the pixels back in the file's channel order
+void bmp32_saveImage(const char *filename, t_bmp32 *img);
+void bmp32_printInfo(t_bmp32 *img);
+
+// --- Image Processing Functions (32-bit) ---
+void bmp32_negative(t_bmp32 *img);
+void bmp32_grayscale(t_bmp32 *img);
+void bmp32_grayscaleRow(t_rgba_pixel *row, int width); // Same conversion as bmp24_grayscaleRow
+void bmp32_brightness(t_bmp32 *img, int value);
+
+// Separable filter given as kernel[ky][kx] = col[ky] * row[kx] (see bmp24_applySeparableFilter)
+void bmp32_applySeparableFilter(t_bmp32 *img, const float *col, const float *row, int kernelSize);
+
+void bmp32_boxBlur(t_bmp32 *img);
+void bmp32_gaussianBlur(t_bmp32 *img);
+void bmp32_outline(t_bmp32 *img);
+void bmp32_emboss(t_bmp32 *img);
+void bmp32_sharpen(t_bmp32 *img);
+
+// Box blur over a (2 * radius + 1)^2 window in O(1) per pixel (running sums)
+void bmp32_boxBlurRadius(t_bmp32 *img, int radius);
+
+#endif // BMP32_H
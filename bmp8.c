@@ -2,6 +2,8 @@
 // Created by Maxence on 25/05/2025.
 //
 #include "bmp8.h"
+#include "convolution.h"
+#include "pixelops.h"
 
 // Helper to extract metadata from header
 void bmp8_extract_metadata(t_bmp8 *img) {
@@ -22,6 +24,67 @@ void bmp8_extract_metadata(t_bmp8 *img) {
     }
 }
 
+// Bytes per row of 8-bit pixel data in the file (width rounded up to a multiple of 4)
+static size_t bmp8_fileRowSize(unsigned int width) {
+    return ((size_t)width + 3) & ~(size_t)3;
+}
+
+// Checks the header already copied into img->header and fills the size fields.
+// *paletteStart receives where the color table starts (right after the info
+// header, which may be larger than BITMAPINFOHEADER) and *offset where the pixels
+// start. Returns 0, or 1 if the file is not an uncompressed 8-bit BMP.
+static int bmp8_parseHeader(t_bmp8 *img, const char *filename, uint32_t *paletteStart, uint32_t *offset) {
+    uint32_t infoSize, compression, ncolors;
+    int32_t width, height;
+    uint16_t depth;
+    memcpy(offset, img->header + BITMAP_OFFSET, sizeof(*offset));
+    memcpy(&infoSize, img->header + BITMAP_HEADER_SIZE, sizeof(infoSize));
+    memcpy(&width, img->header + BITMAP_WIDTH, sizeof(width));
+    memcpy(&height, img->header + BITMAP_HEIGHT, sizeof(height));
+    memcpy(&depth, img->header + BITMAP_DEPTH, sizeof(depth));
+    memcpy(&compression, img->header + BITMAP_COMPRESSION, sizeof(compression));
+    memcpy(&ncolors, img->header + BITMAP_N_COLORS, sizeof(ncolors));
+
+    if (img->header[0] != 'B' || img->header[1] != 'M' || infoSize < DEFAULT_INFO_SIZE_VALUE) {
+        fprintf(stderr, "%s is not a valid BMP file.\n", filename);
+        return 1;
+    }
+    if (depth != 8 || compression != 0) {
+        fprintf(stderr, "Image is not 8-bit\n");
+        return 1;
+    }
+    // Negative heights are top-down images; dataSize must fit its unsigned int
+    if (width <= 0 || height == 0 || height == INT32_MIN ||
+        (uint64_t)width * (uint64_t)(height < 0 ? -(int64_t)height : height) > UINT32_MAX) {
+        fprintf(stderr, "%s: unsupported image size.\n", filename);
+        return 1;
+    }
+
+    img->width = (unsigned int)width;
+    img->height = (unsigned int)abs(height);
+    img->colorDepth = depth;
+    img->dataSize = img->width * img->height;
+
+    // ncolors 0 means a full palette; it also has to fit before the pixels
+    *paletteStart = DEFAULT_HEADER_SIZE_VALUE + infoSize;
+    uint32_t room = (*offset > *paletteStart) ? (*offset - *paletteStart) / 4 : 0;
+    img->numColors = (ncolors == 0 || ncolors > 256) ? 256 : ncolors;
+    if (img->numColors > room) img->numColors = room;
+    if (img->numColors == 0) {
+        fprintf(stderr, "%s has no color table.\n", filename);
+        return 1;
+    }
+    return 0;
+}
+
+// Squeezes rows of `rowSize` bytes into contiguous rows of `width` bytes, in place
+static void bmp8_packRows(unsigned char *data, unsigned int width, unsigned int height, size_t rowSize) {
+    if (rowSize == width) return;
+    for (unsigned int y = 1; y < height; y++) {
+        memmove(data + (size_t)y * width, data + y * rowSize, width);
+    }
+}
+
 t_bmp8* bmp8_loadImage(const char *filename) {
     FILE *file = fopen(filename, "rb");
     if (!file) {
@@ -29,28 +92,111 @@ t_bmp8* bmp8_loadImage(const char *filename) {
         return NULL;
     }
 
-    t_bmp8 *img = (t_bmp8 *)malloc(sizeof(t_bmp8));
-    fread(img->header, sizeof(unsigned char), 54, file);
-    fread(img->colorTable, sizeof(unsigned char), 1024, file);
+    t_bmp8 *img = (t_bmp8 *)calloc(1, sizeof(t_bmp8));
+    if (!img) {
+        perror("Error allocating t_bmp8 struct");
+        fclose(file);
+        return NULL;
+    }
+    uint32_t paletteStart, offset;
+    if (fread(img->header, 1, sizeof(img->header), file) != sizeof(img->header)) {
+        fprintf(stderr, "%s is not a valid BMP file.\n", filename);
+        goto fail;
+    }
+    if (bmp8_parseHeader(img, filename, &paletteStart, &offset) != 0) goto fail;
 
-    img->width = *(unsigned int *)&img->header[18];
-    img->height = *(unsigned int *)&img->header[22];
-    img->colorDepth = *(unsigned int *)&img->header[28];
-    img->dataSize = img->width * img->height;
+    if (fseek(file, paletteStart, SEEK_SET) != 0 ||
+        fread(img->colorTable, 4, img->numColors, file) != img->numColors) {
+        fprintf(stderr, "%s is truncated.\n", filename);
+        goto fail;
+    }
 
-    if (img->colorDepth != 8) {
-        fprintf(stderr, "Image is not 8-bit\n");
+    // One read for all the rows, padding included, then the padding is squeezed out
+    size_t rowSize = bmp8_fileRowSize(img->width);
+    size_t fileBytes = rowSize * img->height;
+    img->data = (unsigned char *)malloc(fileBytes);
+    if (!img->data) {
+        perror("Error allocating pixel data");
+        goto fail;
+    }
+    // The padding of the last row is sometimes missing
+    size_t got = (fseek(file, offset, SEEK_SET) == 0) ? fread(img->data, 1, fileBytes, file) : 0;
+    if (got < fileBytes - (rowSize - img->width)) {
+        fprintf(stderr, "%s is truncated.\n", filename);
+        goto fail;
+    }
+    fclose(file);
+
+    bmp8_packRows(img->data, img->width, img->height, rowSize);
+    if (rowSize != img->width) {
+        unsigned char *packed = (unsigned char *)realloc(img->data, img->dataSize);
+        if (packed) img->data = packed;
+    }
+    return img;
+
+fail:
+    free(img->data);
+    free(img);
+    fclose(file);
+    return NULL;
+}
+
+t_bmp8 *bmp8_mapImage(const char *filename) {
+    size_t size = 0;
+    uint8_t *mapping = file_mapPrivate(filename, &size);
+    if (!mapping) return NULL;
+
+    if (size < 54) {
+        fprintf(stderr, "%s is not a valid BMP file.\n", filename);
+        file_unmap(mapping, size);
+        return NULL;
+    }
+
+    t_bmp8 *img = (t_bmp8 *)calloc(1, sizeof(t_bmp8));
+    if (!img) {
+        perror("Error allocating t_bmp8 struct");
+        file_unmap(mapping, size);
+        return NULL;
+    }
+    memcpy(img->header, mapping, 54);
+
+    uint32_t paletteStart, offset;
+    if (bmp8_parseHeader(img, filename, &paletteStart, &offset) != 0) {
         free(img);
-        fclose(file);
+        file_unmap(mapping, size);
         return NULL;
     }
 
-    img->data = (unsigned char *)malloc(img->dataSize);
-    fread(img->data, sizeof(unsigned char), img->dataSize, file);
-    fclose(file);
+    // Rows are padded to 4 bytes in the file (the last one may lack its padding)
+    size_t rowSize = bmp8_fileRowSize(img->width);
+    if (offset > size || size - offset < rowSize * (img->height - 1) + img->width) {
+        fprintf(stderr, "%s is truncated.\n", filename);
+        free(img);
+        file_unmap(mapping, size);
+        return NULL;
+    }
+    memcpy(img->colorTable, mapping + paletteStart, 4 * img->numColors);
+
+    img->mapping = mapping;
+    img->mappingSize = size;
+    img->data = mapping + offset;
+
+    // Odd widths: the rows stay padded until something writes to the image, so
+    // mapping an image only to read it touches none of its pages
+    img->mappedRowSize = (rowSize != img->width) ? rowSize : 0;
     return img;
 }
 
+int bmp8_makeWritable(t_bmp8 *img) {
+    if (!img || !img->data) return 1;
+    if (img->mappedRowSize) {
+        // Squeezed together inside the private mapping
+        bmp8_packRows(img->data, img->width, img->height, img->mappedRowSize);
+        img->mappedRowSize = 0;
+    }
+    return 0;
+}
+
 void bmp8_saveImage(const char *filename, t_bmp8 *img) {
     if (!img) {
         fprintf(stderr, "Error: Image pointer is NULL in bmp8_saveImage.\n");
@@ -63,30 +209,49 @@ void bmp8_saveImage(const char *filename, t_bmp8 *img) {
         return;
     }
 
+    // The file is always written as a 40-byte info header, the palette and the
+    // padded rows: refresh the fields that depend on that layout
+    unsigned int numColors = (img->numColors == 0 || img->numColors > 256) ? 256 : img->numColors;
+    size_t rowSize = bmp8_fileRowSize(img->width);
+    uint32_t infoSize = DEFAULT_INFO_SIZE_VALUE, ncolors = (numColors == 256) ? 0 : numColors;
+    uint32_t offset = 54 + 4 * numColors;
+    uint32_t imageSize = (uint32_t)(rowSize * img->height), fileSize = offset + imageSize;
+    unsigned char header[54];
+    memcpy(header, img->header, sizeof(header));
+    memcpy(header + BITMAP_FILE_SIZE, &fileSize, sizeof(fileSize));
+    memcpy(header + BITMAP_OFFSET, &offset, sizeof(offset));
+    memcpy(header + BITMAP_HEADER_SIZE, &infoSize, sizeof(infoSize));
+    memcpy(header + BITMAP_IMG_SIZE_RAW, &imageSize, sizeof(imageSize));
+    memcpy(header + BITMAP_N_COLORS, &ncolors, sizeof(ncolors));
+
     // Write header
-    if (fwrite(img->header, 1, 54, file) != 54) {
+    if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
         perror("Error writing BMP header");
         fclose(file);
         return;
     }
 
     // Write color table
-    if (fwrite(img->colorTable, 1, 1024, file) != 1024) {
+    if (fwrite(img->colorTable, 4, numColors, file) != numColors) {
         perror("Error writing color table");
         fclose(file);
         return;
     }
 
-    // Pixel data offset from header
-    uint32_t pixelDataOffset;
-    memcpy(&pixelDataOffset, img->header + BITMAP_OFFSET, sizeof(pixelDataOffset));
-
-    // Ensure file pointer is at the correct position for pixel data
-    // This is important if the offset isn't exactly 54 + 1024
-    fseek(file, pixelDataOffset, SEEK_SET);
-
-    // Write pixel data
-    if (fwrite(img->data, 1, img->dataSize, file) != img->dataSize) {
+    // Write pixel data: in one piece when the rows need no padding
+    static const unsigned char padding[3] = {0, 0, 0};
+    size_t padBytes = rowSize - img->width;
+    size_t step = img->mappedRowSize ? img->mappedRowSize : img->width; // Mapped rows may still be padded
+    int ok = 1;
+    if (padBytes == 0) {
+        ok = fwrite(img->data, 1, img->dataSize, file) == img->dataSize;
+    } else {
+        for (unsigned int y = 0; ok && y < img->height; y++) {
+            ok = fwrite(img->data + (size_t)y * step, 1, img->width, file) == img->width &&
+                 fwrite(padding, 1, padBytes, file) == padBytes;
+        }
+    }
+    if (!ok) {
         perror("Error writing pixel data");
         fclose(file);
         return;
@@ -98,10 +263,13 @@ void bmp8_saveImage(const char *filename, t_bmp8 *img) {
 
 void bmp8_free(t_bmp8 *img) {
     if (img) {
-        if (img->data) {
+        if (img->mapping) {
+            file_unmap(img->mapping, img->mappingSize);
+            img->mapping = NULL;
+        } else if (img->data) {
             free(img->data);
-            img->data = NULL;
         }
+        img->data = NULL;
         free(img);
         img = NULL;
     }
@@ -122,28 +290,21 @@ void bmp8_printInfo(t_bmp8 *img) {
 // --- Image Processing Functions ---
 
 void bmp8_negative(t_bmp8 *img) {
-    if (!img || !img->data) return;
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        img->data[i] = 255 - img->data[i];
-    }
+    if (!img || !img->data || bmp8_makeWritable(img) != 0) return;
+    u8_negative(img->data, img->dataSize);
     printf("Negative filter applied.\n");
 }
 
 void bmp8_brightness(t_bmp8 *img, int value) {
-    if (!img || !img->data) return;
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        int new_val = (int)img->data[i] + value;
-        img->data[i] = (unsigned char)clamp_int(new_val, 0, 255);
-    }
+    if (!img || !img->data || bmp8_makeWritable(img) != 0) return;
+    u8_brightness(img->data, img->dataSize, value); // Saturates at 0 and 255
     printf("Brightness filter applied (value: %d).\n", value);
 }
 
 void bmp8_threshold(t_bmp8 *img, int threshold_val) {
-    if (!img || !img->data) return;
+    if (!img || !img->data || bmp8_makeWritable(img) != 0) return;
     threshold_val = clamp_int(threshold_val, 0, 255); // Ensure threshold is valid
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        img->data[i] = (img->data[i] >= threshold_val) ? 255 : 0;
-    }
+    u8_threshold(img->data, img->dataSize, threshold_val);
     printf("Threshold filter applied (threshold: %d).\n", threshold_val);
 }
 
@@ -152,62 +313,24 @@ void bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize) {
         fprintf(stderr, "Error: Invalid arguments for bmp8_applyFilter.\n");
         return;
     }
+    if (bmp8_makeWritable(img) != 0) return;
 
-    unsigned int width = img->width;
-    unsigned int height = img->height;
-    unsigned char *original_data = (unsigned char *)malloc(img->dataSize);
-    if (!original_data) {
-        perror("Error allocating memory for original data in applyFilter");
-        return;
-    }
-    memcpy(original_data, img->data, img->dataSize);
-
-    int n = kernelSize / 2; // e.g., for 3x3 kernel, n = 1
-
-    // Iterate through pixels, excluding borders (as per PDF)
-    for (unsigned int y = (unsigned int)n; y < height - n; y++) {
-        for (unsigned int x = (unsigned int)n; x < width - n; x++) {
-            float sum = 0.0f;
-            // Apply kernel
-            // The PDF's example: I'_xy = I_{x+1,y+1}*K_{-1,-1} + ...
-            // This means kernel[0][0] maps to relative (-n, -n) from center pixel
-            // And original image I_{x_img, y_img}
-            // Kernel indices k_row, k_col range from 0 to kernelSize-1
-            // Image indices relative to center: (k_col - n), (k_row - n)
-            for (int ky = 0; ky < kernelSize; ky++) { // kernel row
-                for (int kx = 0; kx < kernelSize; kx++) { // kernel col
-                    // PDF example: I_xy' = sum sum I_{x-i, y-j} K_{i,j} where i,j go from -n to n
-                    // To match this, if kernel indices are 0..kernelSize-1
-                    // Kernel K[ky][kx]
-                    // Image pixel at (x + (kx-n), y + (ky-n))
-                    // unsigned int img_x = x + (kx - n);
-                    // unsigned int img_y = y + (ky - n);
-
-                    // PDF second example: I_xy = I_{x+1,y+1}*K_{-1,-1} + ... + I_{x-1,y-1}*K_{1,1}
-                    // This means the kernel is effectively flipped for convolution.
-                    // Or, we interpret K_{i,j} from PDF where i,j = -n..n
-                    // Our kernel is indexed kernel[row_k][col_k] from 0..kernelSize-1
-                    // Let's use the typical convolution way: flip kernel or adjust image indices
-                    // Sum( I[x - kx_centered, y - ky_centered] * K[kx_centered, ky_centered] )
-                    // where kx_centered, ky_centered are -n to n
-                    // So, K[ky][kx] is K_{ky-n, kx-n} in PDF notation
-                    // Image pixel is I_{x - (kx-n), y - (ky-n)}
-                    unsigned int img_x = x - (kx - n);
-                    unsigned int img_y = y - (ky - n);
-
-                    // Boundary check (though we skip borders, this is for correctness if we didn't)
-                    if (img_x < width && img_y < height) { // Ensure within bounds
-                        sum += original_data[img_y * width + img_x] * kernel[ky][kx];
-                    }
-                }
-            }
-            img->data[y * width + x] = (unsigned char)clamp_int((int)roundf(sum), 0, 255);
-        }
-    }
-    free(original_data);
+    // Borders are left untouched (as per PDF); see convolution.h for the indexing.
+    // In place: only a few rows of original data are kept, not a copy of the image.
+    convolve_inplace_u8(img->data, (int)img->width, (int)img->height, img->width, 1, kernel, kernelSize);
     //printf("Convolution filter applied.\n"); // Generic, specific functions will print
 }
 
+void bmp8_applySeparableFilter(t_bmp8 *img, const float *col, const float *row, int kernelSize) {
+    if (!img || !img->data || !col || !row || kernelSize <= 0 || kernelSize % 2 == 0) {
+        fprintf(stderr, "Error: Invalid arguments for bmp8_applySeparableFilter.\n");
+        return;
+    }
+    if (bmp8_makeWritable(img) != 0) return;
+
+    convolve_separable_inplace_u8(img->data, (int)img->width, (int)img->height, img->width, 1,
+                                  col, row, kernelSize);
+}
 
 void bmp8_boxBlur(t_bmp8 *img) {
     bmp8_applyFilter(img, BOX_BLUR_KERNEL, KERNEL_SIZE_3x3);
@@ -233,3 +356,18 @@ void bmp8_sharpen(t_bmp8 *img) {
     bmp8_applyFilter(img, SHARPEN_KERNEL, KERNEL_SIZE_3x3);
     printf("Sharpen filter applied.\n");
 }
+
+void bmp8_boxBlurRadius(t_bmp8 *img, int radius) {
+    if (!img || !img->data || radius <= 0 || radius > BOX_MAX_RADIUS) {
+        fprintf(stderr, "Error: Invalid arguments for bmp8_boxBlurRadius.\n");
+        return;
+    }
+    if ((int)img->width <= 2 * radius || (int)img->height <= 2 * radius) {
+        fprintf(stderr, "Error: Box blur radius %d does not fit the image.\n", radius);
+        return;
+    }
+    if (bmp8_makeWritable(img) != 0) return;
+
+    convolve_box_inplace_u8(img->data, (int)img->width, (int)img->height, img->width, 1, radius);
+    printf("Box blur filter applied (radius: %d).\n", radius);
+}
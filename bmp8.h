@@ -10,19 +10,45 @@
 typedef struct {
     unsigned char header[54];       // BMP file header (54 bytes)
     unsigned char colorTable[1024]; // Color table (256 colors * 4 bytes/color)
-    unsigned char *data;            // Pixel data (grayscale values)
+    unsigned int numColors;         // Entries of colorTable used by the file (0 is read as 256)
+    unsigned char *data;            // Pixel data (width * height bytes, rows in file order, no padding).
+                                    // A mapped image keeps its file padding while mappedRowSize is
+                                    // set: call bmp8_makeWritable before indexing data[y * width + x]
 
     unsigned int width;             // Image width in pixels
     unsigned int height;            // Image height in pixels
     unsigned int colorDepth;        // Bits per pixel (should be 8)
     unsigned int dataSize;          // Size of pixel data in bytes
+
+    unsigned char *mapping;         // File mapping backing `data` (bmp8_mapImage), NULL when data is malloc'd
+    size_t mappingSize;             // Length of the mapping in bytes
+    size_t mappedRowSize;           // Mapped image not written to yet: rows of `data` are still padded
+                                    // to this many bytes as in the file, so row y starts at
+                                    // data + y * mappedRowSize (0 once packed by bmp8_makeWritable)
 } t_bmp8;
 
 // Function to load an 8-bit grayscale BMP image from a file
+// Any uncompressed 8-bit file is accepted: the pixels are read from the header
+// offset in a single read, the row padding is dropped, the color table may have
+// fewer than 256 entries and top-down images (negative height) keep their order.
 // Returns a pointer to t_bmp8 structure or NULL on error.
 t_bmp8 *bmp8_loadImage(const char *filename);
 
+// Function to map an 8-bit grayscale BMP image from a file without copying it.
+// `data` points straight into a private mapping of the file and nothing is touched
+// up front: rows of odd widths keep their file padding (mappedRowSize) until the
+// first write, and pages are only copied when a filter writes to them.
+// Returns a pointer to t_bmp8 structure (release with bmp8_free) or NULL on error.
+t_bmp8 *bmp8_mapImage(const char *filename);
+
+// Packs the rows of a mapped image into width * height bytes if they still have
+// their file padding. Everything that writes `data`, or reads it as width * height
+// bytes, calls it first. Returns 0 on success.
+int bmp8_makeWritable(t_bmp8 *img);
+
 // Function to save an 8-bit grayscale BMP image to a file
+// Rows are padded back to 4 bytes and the offset, sizes and palette count of the
+// header are updated to match what is written.
 void bmp8_saveImage(const char *filename, t_bmp8 *img);
 
 // Function to free the memory allocated for a t_bmp8 image
@@ -49,6 +75,12 @@ void bmp8_threshold(t_bmp8 *img, int threshold_val);
 // kernelSize: the dimension of the square kernel (e.g., 3 for a 3x3 kernel)
 void bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize);
 
+// Applies a separable filter declared as its two 1D factors:
+// kernel[ky][kx] = col[ky] * row[kx], both of length kernelSize (odd).
+// Runs as a horizontal then a vertical pass (2k instead of k*k operations per pixel).
+// bmp8_applyFilter already takes this path for kernels it detects as separable.
+void bmp8_applySeparableFilter(t_bmp8 *img, const float *col, const float *row, int kernelSize);
+
 // Specific filter functions (will call bmp8_applyFilter)
 void bmp8_boxBlur(t_bmp8 *img);
 void bmp8_gaussianBlur(t_bmp8 *img);
@@ -56,5 +88,9 @@ void bmp8_outline(t_bmp8 *img);
 void bmp8_emboss(t_bmp8 *img);
 void bmp8_sharpen(t_bmp8 *img);
 
+// Box blur over a (2 * radius + 1)^2 window, constant cost per pixel whatever the radius.
+// radius 1 matches bmp8_boxBlur within +/-1.
+void bmp8_boxBlurRadius(t_bmp8 *img, int radius);
+
 
 #endif // BMP8_H
@@ -0,0 +1,696 @@
+#include "convolution.h"
+
+// Working set a tile aims for in CONV_TILE_AUTO mode: about half of a typical L2
+#define CONV_TILE_CACHE_BYTES (128u << 10)
+// Narrower tiles spend more time on their edges than they save
+#define CONV_TILE_MIN_WIDTH 64
+
+static int conv_tile_width = CONV_TILE_AUTO;
+
+void set_convolution_tile_width(int pixels) {
+    conv_tile_width = (pixels < 0) ? CONV_TILE_OFF : pixels;
+}
+
+int get_convolution_tile_width(void) {
+    return conv_tile_width;
+}
+
+// Output columns per tile for `columns` interior columns, bytes_per_column being
+// what one column of the tile keeps in cache (source rows, buffers, output)
+static int conv_tile_columns(int columns, size_t bytes_per_column) {
+    int tile = conv_tile_width;
+    if (tile == CONV_TILE_OFF) return columns;
+    if (tile == CONV_TILE_AUTO) {
+        size_t fit = CONV_TILE_CACHE_BYTES / bytes_per_column;
+        tile = (fit < CONV_TILE_MIN_WIDTH) ? CONV_TILE_MIN_WIDTH : (fit > (size_t)columns ? columns : (int)fit);
+    }
+    return (tile < columns) ? tile : columns;
+}
+
+// Channels of a pixel the filters compute: a fourth byte is alpha and stays as it is
+static int conv_color_channels(int channels) {
+    return (channels == 4) ? 3 : channels;
+}
+
+// Puts back the alpha bytes of `count` values of a 4-channel row whose whole pixels
+// were computed (src is the same row before filtering)
+static void conv_keep_alpha(uint8_t *out, const uint8_t *src, int count, int channels) {
+    if (channels != 4) return;
+    for (int i = 3; i < count; i += 4) out[i] = src[i];
+}
+
+// Everything a band of output rows needs
+typedef struct {
+    const uint8_t *src;
+    uint8_t *dst;
+    int width;
+    size_t stride;
+    int channels;
+    float **kernel;
+    int kernelSize;
+    int tile;           // Output columns per tile
+} t_conv_job;
+
+// Computes output pixels [x_begin, x_end) of one row.
+// rows[ky] is the source row kernel row ky lands on, i.e. row y - (ky - n).
+static void convolve_row(const uint8_t **rows, uint8_t *out, int x_begin, int x_end, int channels,
+                         float **kernel, int kernelSize) {
+    int n = kernelSize / 2;
+    int colors = conv_color_channels(channels);
+    for (int x = x_begin; x < x_end; x++) {
+        for (int c = 0; c < colors; c++) {
+            float sum = 0.0f;
+            for (int ky = 0; ky < kernelSize; ky++) {
+                const uint8_t *row = rows[ky];
+                const float *k = kernel[ky];
+                for (int kx = 0; kx < kernelSize; kx++) {
+                    sum += row[(x - (kx - n)) * channels + c] * k[kx];
+                }
+            }
+            out[x * channels + c] = (uint8_t)clamp_int((int)roundf(sum), 0, 255);
+        }
+    }
+}
+
+static void convolve_band(int y_begin, int y_end, void *arg) {
+    t_conv_job *job = (t_conv_job *)arg;
+    int n = job->kernelSize / 2;
+
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    const uint8_t **rows = (const uint8_t **)arena_alloc(arena, job->kernelSize * sizeof(const uint8_t *));
+    if (!rows) {
+        perror("Error allocating row table for convolution");
+        return;
+    }
+    // Column tiles, each swept down the whole band while its rows are in cache
+    for (int x0 = n; x0 < job->width - n; x0 += job->tile) {
+        int x1 = (x0 + job->tile < job->width - n) ? x0 + job->tile : job->width - n;
+        for (int y = y_begin; y < y_end; y++) {
+            for (int ky = 0; ky < job->kernelSize; ky++) {
+                rows[ky] = job->src + (size_t)(y - (ky - n)) * job->stride;
+            }
+            convolve_row(rows, job->dst + (size_t)y * job->stride, x0, x1, job->channels,
+                         job->kernel, job->kernelSize);
+        }
+    }
+    arena_release(arena, mark);
+}
+
+static t_conv_job conv_2d_job(const uint8_t *src, uint8_t *dst, int width, size_t stride, int channels,
+                              float **kernel, int kernelSize) {
+    int tile = conv_tile_columns(width - 2 * (kernelSize / 2), (size_t)(kernelSize + 1) * channels);
+    t_conv_job job = {src, dst, width, stride, channels, kernel, kernelSize, tile};
+    return job;
+}
+
+void convolve_2d_u8(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                    float **kernel, int kernelSize) {
+    int n = kernelSize / 2;
+    if (!src || !dst || !kernel || width <= 2 * n || height <= 2 * n) return;
+
+    t_conv_job job = conv_2d_job(src, dst, width, stride, channels, kernel, kernelSize);
+    parallel_for(n, height - n, convolve_band, &job);
+}
+
+// --- Separable kernels ---
+
+int kernel_separate(float **kernel, int kernelSize, float *col, float *row) {
+    if (!kernel || kernelSize <= 0) return 0;
+
+    // Pivot on the largest entry: kernel = (column through pivot / pivot) * (row through pivot)
+    int py = 0, px = 0;
+    float max_abs = 0.0f;
+    for (int ky = 0; ky < kernelSize; ky++) {
+        for (int kx = 0; kx < kernelSize; kx++) {
+            if (fabsf(kernel[ky][kx]) > max_abs) {
+                max_abs = fabsf(kernel[ky][kx]);
+                py = ky;
+                px = kx;
+            }
+        }
+    }
+    if (max_abs == 0.0f) return 0;
+
+    for (int k = 0; k < kernelSize; k++) {
+        row[k] = kernel[py][k];
+        col[k] = kernel[k][px] / kernel[py][px];
+    }
+
+    float tolerance = 1e-6f * max_abs;
+    for (int ky = 0; ky < kernelSize; ky++) {
+        for (int kx = 0; kx < kernelSize; kx++) {
+            if (fabsf(kernel[ky][kx] - col[ky] * row[kx]) > tolerance) return 0;
+        }
+    }
+    return 1;
+}
+
+typedef struct {
+    const uint8_t *src;
+    uint8_t *dst;
+    int width;
+    size_t stride;
+    int channels;
+    const float *col;
+    const float *row;
+    int kernelSize;
+    int tile;
+} t_sep_job;
+
+// Horizontal pass over `count` values of one source row, src pointing at the first
+// output position. Channels are interleaved, so a pixel step is `channels` values.
+static void separable_horizontal(const uint8_t *src, float *out, int count, int channels,
+                                 const float *row, int kernelSize) {
+    int n = kernelSize / 2;
+    for (int i = 0; i < count; i++) out[i] = 0.0f;
+    for (int kx = 0; kx < kernelSize; kx++) {
+        const uint8_t *shifted = src - (kx - n) * channels;
+        float k = row[kx];
+        for (int i = 0; i < count; i++) {
+            out[i] += shifted[i] * k;
+        }
+    }
+}
+
+// Each band keeps the horizontal results of the last k source rows in a ring,
+// so every source row is filtered horizontally once per band. The ring only
+// spans one column tile, which keeps it in cache on wide images.
+static void separable_band(int y_begin, int y_end, void *arg) {
+    t_sep_job *job = (t_sep_job *)arg;
+    int k = job->kernelSize;
+    int n = k / 2;
+    size_t tile_values = (size_t)job->tile * job->channels;
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    float *ring = (float *)arena_alloc(arena, (k + 1) * tile_values * sizeof(float)); // k rows + accumulator
+    if (!ring) {
+        perror("Error allocating row buffers for separable convolution");
+        return;
+    }
+    float *acc = ring + k * tile_values;
+
+    for (int x0 = n; x0 < job->width - n; x0 += job->tile) {
+        int x1 = (x0 + job->tile < job->width - n) ? x0 + job->tile : job->width - n;
+        int count = (x1 - x0) * job->channels;
+        size_t offset = (size_t)x0 * job->channels;
+
+        // Prime the ring with source rows y_begin - n .. y_begin + n - 1
+        for (int r = y_begin - n; r < y_begin + n; r++) {
+            separable_horizontal(job->src + (size_t)r * job->stride + offset,
+                                 ring + (size_t)((r + k) % k) * tile_values, count, job->channels, job->row, k);
+        }
+
+        for (int y = y_begin; y < y_end; y++) {
+            int incoming = y + n;
+            separable_horizontal(job->src + (size_t)incoming * job->stride + offset,
+                                 ring + (size_t)(incoming % k) * tile_values, count, job->channels, job->row, k);
+
+            for (int i = 0; i < count; i++) acc[i] = 0.0f;
+            for (int ky = 0; ky < k; ky++) {
+                const float *h = ring + (size_t)((y - (ky - n) + k) % k) * tile_values;
+                float c = job->col[ky];
+                for (int i = 0; i < count; i++) {
+                    acc[i] += h[i] * c;
+                }
+            }
+
+            uint8_t *out = job->dst + (size_t)y * job->stride + offset;
+            for (int i = 0; i < count; i++) {
+                out[i] = (uint8_t)clamp_int((int)roundf(acc[i]), 0, 255);
+            }
+            conv_keep_alpha(out, job->src + (size_t)y * job->stride + offset, count, job->channels);
+        }
+    }
+    arena_release(arena, mark);
+}
+
+static t_sep_job separable_job(const uint8_t *src, uint8_t *dst, int width, size_t stride, int channels,
+                               const float *col, const float *row, int kernelSize) {
+    // Per column: k + 1 float rows in the ring, k + 1 source rows and the output
+    int tile = conv_tile_columns(width - 2 * (kernelSize / 2),
+                                 (size_t)((kernelSize + 1) * sizeof(float) + kernelSize + 2) * channels);
+    t_sep_job job = {src, dst, width, stride, channels, col, row, kernelSize, tile};
+    return job;
+}
+
+void convolve_separable_u8(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                           const float *col, const float *row, int kernelSize) {
+    int n = kernelSize / 2;
+    if (!src || !dst || !col || !row || width <= 2 * n || height <= 2 * n) return;
+
+    t_sep_job job = separable_job(src, dst, width, stride, channels, col, row, kernelSize);
+    parallel_for(n, height - n, separable_band, &job);
+}
+
+// --- Box blur of any radius ---
+
+typedef struct {
+    const uint8_t *src;
+    uint8_t *dst;
+    int width;
+    size_t stride;
+    int channels;
+    int radius;
+    int tile;
+} t_box_job;
+
+static void box_band(int y_begin, int y_end, void *arg) {
+    t_box_job *job = (t_box_job *)arg;
+    int r = job->radius;
+    int ch = job->channels;
+    uint32_t area = (uint32_t)(2 * r + 1) * (uint32_t)(2 * r + 1);
+
+    // colsum[i]: sum over the 2r + 1 source rows around the current row of value i
+    // of the tile, counted from r pixels left of the tile
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    uint32_t *colsum = (uint32_t *)arena_alloc(arena, (size_t)(job->tile + 2 * r) * ch * sizeof(uint32_t));
+    if (!colsum) {
+        perror("Error allocating column sums for box blur");
+        return;
+    }
+
+    for (int x0 = r; x0 < job->width - r; x0 += job->tile) {
+        int x1 = (x0 + job->tile < job->width - r) ? x0 + job->tile : job->width - r;
+        int count = (x1 - x0) * ch;
+        int sum_values = count + 2 * r * ch;
+        size_t offset = (size_t)(x0 - r) * ch;
+
+        memset(colsum, 0, sum_values * sizeof(uint32_t));
+        for (int y = y_begin - r; y <= y_begin + r; y++) {
+            const uint8_t *row = job->src + (size_t)y * job->stride + offset;
+            for (int i = 0; i < sum_values; i++) colsum[i] += row[i];
+        }
+
+        for (int y = y_begin; y < y_end; y++) {
+            uint8_t *out = job->dst + (size_t)y * job->stride + (size_t)x0 * ch;
+
+            // Window sums along the row; the first pixel of each channel is summed in full
+            for (int c = 0; c < conv_color_channels(ch); c++) {
+                uint32_t sum = 0;
+                for (int x = 0; x <= 2 * r; x++) sum += colsum[x * ch + c];
+                out[c] = (uint8_t)((sum + area / 2) / area);
+                for (int i = ch + c; i < count; i += ch) {
+                    sum += colsum[i + 2 * r * ch] - colsum[i - ch];
+                    out[i] = (uint8_t)((sum + area / 2) / area);
+                }
+            }
+
+            // Slide the column sums one row down
+            if (y + 1 < y_end) {
+                const uint8_t *leaving = job->src + (size_t)(y - r) * job->stride + offset;
+                const uint8_t *entering = job->src + (size_t)(y + r + 1) * job->stride + offset;
+                for (int i = 0; i < sum_values; i++) colsum[i] += (uint32_t)entering[i] - leaving[i];
+            }
+        }
+    }
+    arena_release(arena, mark);
+}
+
+static t_box_job box_job(const uint8_t *src, uint8_t *dst, int width, size_t stride, int channels, int radius) {
+    // Per column: the column sums plus the two source rows and the output
+    int tile = conv_tile_columns(width - 2 * radius, (sizeof(uint32_t) + 3) * channels);
+    t_box_job job = {src, dst, width, stride, channels, radius, tile};
+    return job;
+}
+
+void convolve_box_u8(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                     int radius) {
+    if (!src || !dst || radius <= 0 || radius > BOX_MAX_RADIUS || width <= 2 * radius || height <= 2 * radius) return;
+
+    t_box_job job = box_job(src, dst, width, stride, channels, radius);
+    parallel_for(radius, height - radius, box_band, &job);
+}
+
+// --- Fixed-point mode ---
+
+static t_conv_precision conv_precision = CONV_PRECISION_FLOAT;
+
+void set_convolution_precision(t_conv_precision precision) {
+    conv_precision = precision;
+}
+
+t_conv_precision get_convolution_precision(void) {
+    return conv_precision;
+}
+
+// fixed_kernel_quantize into caller-provided storage for kernelSize^2 weights
+static int fixed_kernel_quantize_to(float **kernel, int kernelSize, t_fixed_kernel *fixed, int16_t *weights) {
+    float max_abs = 0.0f, sum_abs = 0.0f, sum = 0.0f;
+    for (int ky = 0; ky < kernelSize; ky++) {
+        for (int kx = 0; kx < kernelSize; kx++) {
+            float w = kernel[ky][kx];
+            if (fabsf(w) > max_abs) max_abs = fabsf(w);
+            sum_abs += fabsf(w);
+            sum += w;
+        }
+    }
+    if (max_abs == 0.0f) return 0;
+
+    // Largest shift with |w| * 2^shift <= 32767 and 255 * sum|w| * 2^shift (+ rounding) < 2^31
+    int shift = 0;
+    while (shift < 24 &&
+           max_abs * (float)(1 << (shift + 1)) <= 32767.0f &&
+           255.0f * sum_abs * (float)(1 << (shift + 1)) < 2147483647.0f / 2.0f) {
+        shift++;
+    }
+    if (max_abs * (float)(1 << shift) < 0.5f) return 0; // Would quantize to all zeros
+
+    float scale = (float)(1 << shift);
+    long total = 0;
+    int largest = 0;
+    for (int ky = 0; ky < kernelSize; ky++) {
+        for (int kx = 0; kx < kernelSize; kx++) {
+            int i = ky * kernelSize + kx;
+            weights[i] = (int16_t)lroundf(kernel[ky][kx] * scale);
+            total += weights[i];
+            if (abs(weights[i]) > abs(weights[largest])) largest = i;
+        }
+    }
+    // Keep the sum of the weights (the gain of the filter) exact
+    long correction = lroundf(sum * scale) - total;
+    long adjusted = weights[largest] + correction;
+    if (adjusted >= -32768 && adjusted <= 32767) weights[largest] = (int16_t)adjusted;
+
+    fixed->weights = weights;
+    fixed->kernelSize = kernelSize;
+    fixed->shift = shift;
+    return 1;
+}
+
+int fixed_kernel_quantize(float **kernel, int kernelSize, t_fixed_kernel *fixed) {
+    if (!kernel || !fixed || kernelSize <= 0) return 0;
+    int16_t *weights = (int16_t *)malloc(kernelSize * kernelSize * sizeof(int16_t));
+    if (!weights) return 0;
+    if (!fixed_kernel_quantize_to(kernel, kernelSize, fixed, weights)) {
+        free(weights);
+        return 0;
+    }
+    return 1;
+}
+
+void fixed_kernel_free(t_fixed_kernel *fixed) {
+    if (!fixed) return;
+    free(fixed->weights);
+    fixed->weights = NULL;
+}
+
+typedef struct {
+    const uint8_t *src;
+    uint8_t *dst;
+    int width;
+    size_t stride;
+    int channels;
+    const t_fixed_kernel *fixed;
+    int tile;
+} t_fixed_job;
+
+static void fixed_band(int y_begin, int y_end, void *arg) {
+    t_fixed_job *job = (t_fixed_job *)arg;
+    int k = job->fixed->kernelSize;
+    int n = k / 2;
+    int shift = job->fixed->shift;
+    int32_t half = (shift > 0) ? (1 << (shift - 1)) : 0;
+
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    int32_t *acc = (int32_t *)arena_alloc(arena, (size_t)job->tile * job->channels * sizeof(int32_t));
+    if (!acc) {
+        perror("Error allocating accumulator for fixed-point convolution");
+        return;
+    }
+    for (int x0 = n; x0 < job->width - n; x0 += job->tile) {
+        int x1 = (x0 + job->tile < job->width - n) ? x0 + job->tile : job->width - n;
+        int count = (x1 - x0) * job->channels;
+        size_t offset = (size_t)x0 * job->channels;
+
+        for (int y = y_begin; y < y_end; y++) {
+            for (int i = 0; i < count; i++) acc[i] = half;
+            // One weight at a time over the whole tile row: widening multiply-adds the compiler vectorizes
+            for (int ky = 0; ky < k; ky++) {
+                const uint8_t *row = job->src + (size_t)(y - (ky - n)) * job->stride + offset;
+                for (int kx = 0; kx < k; kx++) {
+                    int32_t w = job->fixed->weights[ky * k + kx];
+                    if (w == 0) continue;
+                    const uint8_t *shifted = row - (kx - n) * job->channels;
+                    for (int i = 0; i < count; i++) {
+                        acc[i] += w * (int32_t)shifted[i];
+                    }
+                }
+            }
+            uint8_t *out = job->dst + (size_t)y * job->stride + offset;
+            for (int i = 0; i < count; i++) {
+                int32_t v = acc[i];
+                v = (v < 0) ? 0 : (v >> shift); // Negative sums clamp to 0 anyway
+                out[i] = (uint8_t)(v > 255 ? 255 : v);
+            }
+            conv_keep_alpha(out, job->src + (size_t)y * job->stride + offset, count, job->channels);
+        }
+    }
+    arena_release(arena, mark);
+}
+
+static t_fixed_job fixed_job(const uint8_t *src, uint8_t *dst, int width, size_t stride, int channels,
+                             const t_fixed_kernel *fixed) {
+    // Per column: the int32 accumulator, k source rows and the output
+    int tile = conv_tile_columns(width - 2 * (fixed->kernelSize / 2), (sizeof(int32_t) + fixed->kernelSize + 1) * channels);
+    t_fixed_job job = {src, dst, width, stride, channels, fixed, tile};
+    return job;
+}
+
+void convolve_fixed_u8(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                       const t_fixed_kernel *fixed) {
+    if (!src || !dst || !fixed || !fixed->weights) return;
+    int n = fixed->kernelSize / 2;
+    if (width <= 2 * n || height <= 2 * n) return;
+
+    t_fixed_job job = fixed_job(src, dst, width, stride, channels, fixed);
+    parallel_for(n, height - n, fixed_band, &job);
+}
+
+// --- In-place convolution ---
+//
+// The output rows [radius, height - radius) are cut into one band per thread.
+// Before the bands start, the 2 * radius original rows around every boundary
+// between two bands are saved: they are the only rows a band reads that another
+// band writes. Each band then goes down its rows in steps, keeping the original
+// rows the next step needs above it in a small window, and runs the usual band
+// function with the window as src and the image as dst.
+
+// Smallest step in output rows; steps also cover at least two kernel windows so
+// that priming the band functions (separable ring, box column sums) stays cheap
+#define CONV_INPLACE_MIN_STEP 64
+
+typedef enum { BAND_2D, BAND_SEPARABLE, BAND_BOX, BAND_FIXED } t_band_kind;
+
+// Any of the band jobs above
+typedef struct {
+    t_band_kind kind;
+    union {
+        t_conv_job conv;
+        t_sep_job sep;
+        t_box_job box;
+        t_fixed_job fixed;
+    } u;
+} t_band_job;
+
+// Runs output rows [y_begin, y_end) of `job` from src into dst
+static void band_run(t_band_job job, const uint8_t *src, uint8_t *dst, int y_begin, int y_end) {
+    switch (job.kind) {
+        case BAND_2D:
+            job.u.conv.src = src;
+            job.u.conv.dst = dst;
+            convolve_band(y_begin, y_end, &job.u.conv);
+            break;
+        case BAND_SEPARABLE:
+            job.u.sep.src = src;
+            job.u.sep.dst = dst;
+            separable_band(y_begin, y_end, &job.u.sep);
+            break;
+        case BAND_BOX:
+            job.u.box.src = src;
+            job.u.box.dst = dst;
+            box_band(y_begin, y_end, &job.u.box);
+            break;
+        case BAND_FIXED:
+            job.u.fixed.src = src;
+            job.u.fixed.dst = dst;
+            fixed_band(y_begin, y_end, &job.u.fixed);
+            break;
+    }
+}
+
+typedef struct {
+    t_band_job band;
+    uint8_t *pixels;
+    size_t stride;
+    int radius;
+    int rows;           // Output rows, starting at row `radius`
+    int num_bands;
+    int step;           // Output rows per step
+    uint8_t *halos;     // Rows [Y - radius, Y + radius) around each band boundary Y
+} t_inplace_job;
+
+static int inplace_band_start(const t_inplace_job *job, int band) {
+    return job->radius + (int)((long long)job->rows * band / job->num_bands);
+}
+
+// Original content of row y, as seen from `band`
+static const uint8_t *inplace_source_row(const t_inplace_job *job, int band, int y) {
+    int top = inplace_band_start(job, band);
+    int bottom = inplace_band_start(job, band + 1);
+    size_t halo_rows = 2 * (size_t)job->radius;
+    if (y < top && band > 0) {
+        return job->halos + ((band - 1) * halo_rows + (size_t)(y - top + job->radius)) * job->stride;
+    }
+    if (y >= bottom && band + 1 < job->num_bands) {
+        return job->halos + (band * halo_rows + (size_t)(y - bottom + job->radius)) * job->stride;
+    }
+    // Own rows not written yet, or border rows that are never written
+    return job->pixels + (size_t)y * job->stride;
+}
+
+static void inplace_bands(int band_begin, int band_end, void *arg) {
+    const t_inplace_job *job = (const t_inplace_job *)arg;
+    int r = job->radius;
+    size_t stride = job->stride;
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    uint8_t *window = (uint8_t *)arena_alloc(arena, (size_t)(job->step + 2 * r) * stride);
+    if (!window) {
+        perror("Error allocating row window for in-place convolution");
+        return;
+    }
+
+    for (int band = band_begin; band < band_end; band++) {
+        int top = inplace_band_start(job, band);
+        int bottom = inplace_band_start(job, band + 1);
+        for (int y0 = top; y0 < bottom; y0 += job->step) {
+            int y1 = (y0 + job->step < bottom) ? y0 + job->step : bottom;
+
+            // The window holds the original rows [y0 - r, y1 + r); the first 2r
+            // were loaded by the previous (full) step
+            int first_new = y0 - r;
+            if (y0 > top) {
+                memmove(window, window + (size_t)job->step * stride, 2 * (size_t)r * stride);
+                first_new = y0 + r;
+            }
+            for (int y = first_new; y < y1 + r; y++) {
+                memcpy(window + (size_t)(y - (y0 - r)) * stride, inplace_source_row(job, band, y), stride);
+            }
+            band_run(job->band, window, job->pixels + (size_t)(y0 - r) * stride, r, r + (y1 - y0));
+        }
+    }
+    arena_release(arena, mark);
+}
+
+// Caller checks that the image is larger than 2 * radius in both directions
+static void convolve_in_place(t_band_job band, uint8_t *pixels, int height, size_t stride, int radius) {
+    t_inplace_job job = {band, pixels, stride, radius, height - 2 * radius, 1, 0, NULL};
+    job.step = 2 * (2 * radius + 1);
+    if (job.step < CONV_INPLACE_MIN_STEP) job.step = CONV_INPLACE_MIN_STEP;
+    job.num_bands = get_num_threads();
+    if (job.num_bands > job.rows / job.step) job.num_bands = job.rows / job.step;
+    if (job.num_bands < 1) job.num_bands = 1;
+
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    if (job.num_bands > 1) {
+        size_t halo_size = 2 * (size_t)radius * stride;
+        job.halos = (uint8_t *)arena_alloc(arena, (job.num_bands - 1) * halo_size);
+        if (!job.halos) {
+            perror("Error allocating band halos for in-place convolution");
+            return;
+        }
+        for (int b = 1; b < job.num_bands; b++) {
+            memcpy(job.halos + (b - 1) * halo_size,
+                   pixels + (size_t)(inplace_band_start(&job, b) - radius) * stride, halo_size);
+        }
+    }
+    parallel_for(0, job.num_bands, inplace_bands, &job);
+    arena_release(arena, mark);
+}
+
+static void convolve_2d_inplace_u8(uint8_t *pixels, int width, int height, size_t stride, int channels,
+                                   float **kernel, int kernelSize) {
+    int n = kernelSize / 2;
+    if (!pixels || !kernel || width <= 2 * n || height <= 2 * n) return;
+
+    t_band_job job = {BAND_2D, {.conv = conv_2d_job(NULL, NULL, width, stride, channels, kernel, kernelSize)}};
+    convolve_in_place(job, pixels, height, stride, n);
+}
+
+static void convolve_fixed_inplace_u8(uint8_t *pixels, int width, int height, size_t stride, int channels,
+                                      const t_fixed_kernel *fixed) {
+    int n = fixed->kernelSize / 2;
+    if (!pixels || width <= 2 * n || height <= 2 * n) return;
+
+    t_band_job job = {BAND_FIXED, {.fixed = fixed_job(NULL, NULL, width, stride, channels, fixed)}};
+    convolve_in_place(job, pixels, height, stride, n);
+}
+
+void convolve_separable_inplace_u8(uint8_t *pixels, int width, int height, size_t stride, int channels,
+                                   const float *col, const float *row, int kernelSize) {
+    int n = kernelSize / 2;
+    if (!pixels || !col || !row || width <= 2 * n || height <= 2 * n) return;
+
+    t_band_job job = {BAND_SEPARABLE, {.sep = separable_job(NULL, NULL, width, stride, channels, col, row, kernelSize)}};
+    convolve_in_place(job, pixels, height, stride, n);
+}
+
+void convolve_box_inplace_u8(uint8_t *pixels, int width, int height, size_t stride, int channels, int radius) {
+    if (!pixels || radius <= 0 || radius > BOX_MAX_RADIUS || width <= 2 * radius || height <= 2 * radius) return;
+
+    t_band_job job = {BAND_BOX, {.box = box_job(NULL, NULL, width, stride, channels, radius)}};
+    convolve_in_place(job, pixels, height, stride, radius);
+}
+
+// Path selection of convolve_u8 and convolve_inplace_u8 (src NULL: in place on dst)
+static void convolve_dispatch(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                              float **kernel, int kernelSize) {
+    if (!kernel || kernelSize <= 0) return;
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+
+    if (conv_precision == CONV_PRECISION_FIXED) {
+        t_fixed_kernel fixed;
+        int16_t *weights = (int16_t *)arena_alloc(arena, kernelSize * kernelSize * sizeof(int16_t));
+        if (weights && fixed_kernel_quantize_to(kernel, kernelSize, &fixed, weights)) {
+            if (src) convolve_fixed_u8(src, dst, width, height, stride, channels, &fixed);
+            else convolve_fixed_inplace_u8(dst, width, height, stride, channels, &fixed);
+            arena_release(arena, mark);
+            return;
+        }
+        // Not representable: fall through to the float path
+    }
+    // Below 3x3 the two passes cost as much as the 2D loop
+    if (kernelSize >= 3) {
+        float *factors = (float *)arena_alloc(arena, 2 * kernelSize * sizeof(float));
+        if (factors && kernel_separate(kernel, kernelSize, factors, factors + kernelSize)) {
+            if (src) {
+                convolve_separable_u8(src, dst, width, height, stride, channels, factors, factors + kernelSize, kernelSize);
+            } else {
+                convolve_separable_inplace_u8(dst, width, height, stride, channels, factors, factors + kernelSize,
+                                              kernelSize);
+            }
+            arena_release(arena, mark);
+            return;
+        }
+    }
+    arena_release(arena, mark);
+    if (src) convolve_2d_u8(src, dst, width, height, stride, channels, kernel, kernelSize);
+    else convolve_2d_inplace_u8(dst, width, height, stride, channels, kernel, kernelSize);
+}
+
+void convolve_u8(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                 float **kernel, int kernelSize) {
+    if (!src) return;
+    convolve_dispatch(src, dst, width, height, stride, channels, kernel, kernelSize);
+}
+
+void convolve_inplace_u8(uint8_t *pixels, int width, int height, size_t stride, int channels,
+                         float **kernel, int kernelSize) {
+    if (!pixels) return;
+    convolve_dispatch(NULL, pixels, width, height, stride, channels, kernel, kernelSize);
+}
@@ -0,0 +1,111 @@
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include "utils.h"
+
+// Convolution engine shared by the 8-bit and 24-bit filters.
+//
+// Images are passed as raw interleaved buffers: `height` rows of `stride`
+// bytes, `channels` bytes per pixel (1 for t_bmp8, 3 for t_bmp24, 4 for
+// t_bmp32). Every channel is convolved independently, except the fourth byte
+// of 4-channel pixels (alpha), which is left as it is.
+//
+// Like the original filters, only the interior is computed: the kernelSize/2
+// outermost rows and columns of dst are left untouched. The kernel is applied
+// flipped (true convolution): dst(x, y) = sum K[ky][kx] * src(x - (kx - n), y - (ky - n)).
+//
+// Output rows are split into bands processed in parallel (see set_num_threads).
+// Each pixel is computed exactly as in the serial loop, so the result does not
+// depend on the thread count.
+
+// Entry point used by the filters. In float precision (default) it runs the
+// separable fast path when the kernel is rank-1 (box, Gaussian) and the full
+// 2D convolution otherwise; in fixed precision it runs convolve_fixed_u8.
+// src and dst must not overlap.
+void convolve_u8(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                 float **kernel, int kernelSize);
+
+// Full 2D convolution, k*k multiplies per pixel and channel
+void convolve_2d_u8(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                    float **kernel, int kernelSize);
+
+// Convolution by the separable kernel K[ky][kx] = col[ky] * row[kx]: a horizontal
+// pass then a vertical pass, 2k multiplies per pixel and channel. Intermediate
+// sums stay in float, so the result matches convolve_2d_u8 within +/-1.
+void convolve_separable_u8(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                           const float *col, const float *row, int kernelSize);
+
+// 255 * (2r + 1)^2 must fit the 32-bit window sums of the box blur
+#define BOX_MAX_RADIUS 2047
+
+// Box blur of any radius ((2 * radius + 1)^2 window) in O(1) per pixel: running
+// column sums slid down each band plus a running sum along the row. Integer
+// arithmetic, rounded to nearest; the borders (radius rows/columns) are left
+// untouched like the other filters. Nothing is done unless 0 < radius <=
+// BOX_MAX_RADIUS and the window fits the image (width and height > 2 * radius).
+void convolve_box_u8(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                     int radius);
+
+// --- In-place versions ---
+// Same result as copying the image and passing the copy as src, without the
+// copy: each thread keeps a window of original rows (64, or two kernel heights
+// for large kernels, plus the kernel height), and 2 * (kernelSize / 2) rows are
+// saved per boundary between threads. Extra memory is O(kernelSize * stride *
+// threads) instead of the whole image.
+
+void convolve_inplace_u8(uint8_t *pixels, int width, int height, size_t stride, int channels,
+                         float **kernel, int kernelSize);
+void convolve_separable_inplace_u8(uint8_t *pixels, int width, int height, size_t stride, int channels,
+                                   const float *col, const float *row, int kernelSize);
+void convolve_box_inplace_u8(uint8_t *pixels, int width, int height, size_t stride, int channels, int radius);
+
+// --- Tiled execution ---
+// Each band is swept in column tiles: all the rows of the band for the first
+// tile, then the next tile. On wide images the rows a kernel touches (and the
+// row buffers of the separable, box and fixed-point paths) no longer fit in
+// L1/L2 between two output rows; a tile narrow enough keeps them there.
+// Pixels are computed exactly as without tiles, so the output is identical.
+
+#define CONV_TILE_AUTO 0  // Width picked per filter to fit about 128 KB (default)
+#define CONV_TILE_OFF -1  // Whole rows, as before tiling
+
+// Tile width in output pixels, or CONV_TILE_AUTO / CONV_TILE_OFF
+void set_convolution_tile_width(int pixels);
+int get_convolution_tile_width(void);
+
+// --- Fixed-point mode ---
+
+// Arithmetic used by convolve_u8 (and therefore by every filter)
+typedef enum {
+    CONV_PRECISION_FLOAT, // float accumulation, roundf (default)
+    CONV_PRECISION_FIXED  // int16 weights, int32 accumulation, rounding shift
+} t_conv_precision;
+
+void set_convolution_precision(t_conv_precision precision);
+t_conv_precision get_convolution_precision(void);
+
+// Kernel quantized to integers: weights[ky * kernelSize + kx] ~= kernel[ky][kx] * 2^shift
+typedef struct {
+    int16_t *weights;
+    int kernelSize;
+    int shift;
+} t_fixed_kernel;
+
+// Quantizes kernel with the largest shift that keeps every weight in int16 and any
+// sum of 8-bit pixels times weights in int32. The rounding error of the weights is
+// pushed onto the largest one so their sum stays as close to the float sum as possible.
+// Returns 1 on success, 0 if the kernel cannot be represented. Release with fixed_kernel_free.
+int fixed_kernel_quantize(float **kernel, int kernelSize, t_fixed_kernel *fixed);
+void fixed_kernel_free(t_fixed_kernel *fixed);
+
+// Integer 2D convolution: out = clamp((sum + 2^(shift-1)) >> shift, 0, 255).
+// Differs from the float path only through the quantization of the weights
+// (kernels whose weights are multiples of 2^-shift give identical results).
+void convolve_fixed_u8(const uint8_t *src, uint8_t *dst, int width, int height, size_t stride, int channels,
+                       const t_fixed_kernel *fixed);
+
+// Checks whether kernel is (numerically) rank-1, i.e. kernel[ky][kx] == col[ky] * row[kx].
+// On success fills col and row (kernelSize entries each) and returns 1, otherwise returns 0.
+int kernel_separate(float **kernel, int kernelSize, float *col, float *row);
+
+#endif // CONVOLUTION_H
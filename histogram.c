@@ -1,5 +1,149 @@
 #include "histogram.h"
+#include "pixelops.h"
 #include <stdio.h>
+
+// --- Histogram engine ---
+
+// Buffers below this size are counted on the calling thread
+#define HISTOGRAM_PARALLEL_MIN (1u << 20)
+// Rows of a flat buffer handed to histogram_count_u8
+#define HISTOGRAM_FLAT_ROW 4096
+// Pixels converted to luma at a time (bmp24_computeStats)
+#define HISTOGRAM_LUMA_CHUNK 1024
+// Interleaved sub-histograms per band: consecutive pixels with the same value
+// land in different counters instead of waiting on each other's increment
+#define HISTOGRAM_WAYS 4
+
+typedef struct {
+    const uint8_t *src;
+    int width, height;
+    size_t stride;
+    int channels;
+    int with_luma;          // RGB only: also count rgb_row_to_luma in a fourth table
+    int num_parts;
+    unsigned int *partials; // num_parts tables of channels * 256 counts
+    int bgr;                // Pixels in file order (B,G,R): only changes the luma
+} t_histogram_job;
+
+// Adds the counts of rows [row_begin, row_end) to `out`
+static void histogram_count_rows(const t_histogram_job *job, int row_begin, int row_end, unsigned int *out) {
+    uint32_t sub[HISTOGRAM_WAYS][HISTOGRAM_MAX_CHANNELS * 256];
+    uint8_t luma[HISTOGRAM_LUMA_CHUNK];
+    t_rgb_pixel swapped[HISTOGRAM_LUMA_CHUNK]; // R,G,B copy of a chunk of B,G,R pixels
+    int bins = (job->channels + job->with_luma) * 256;
+    memset(sub, 0, sizeof(sub));
+
+    for (int y = row_begin; y < row_end; y++) {
+        const uint8_t *row = job->src + (size_t)y * job->stride;
+        int x = 0;
+        if (job->channels == 1) {
+            for (; x + HISTOGRAM_WAYS <= job->width; x += HISTOGRAM_WAYS) {
+                sub[0][row[x]]++;
+                sub[1][row[x + 1]]++;
+                sub[2][row[x + 2]]++;
+                sub[3][row[x + 3]]++;
+            }
+            for (; x < job->width; x++) sub[0][row[x]]++;
+        } else if (job->channels == 3) {
+            // The three channels already use separate tables, two ways are enough
+            for (; x + 2 <= job->width; x += 2) {
+                const uint8_t *px = row + (size_t)x * 3;
+                sub[0][px[0]]++;
+                sub[0][256 + px[1]]++;
+                sub[0][512 + px[2]]++;
+                sub[1][px[3]]++;
+                sub[1][256 + px[4]]++;
+                sub[1][512 + px[5]]++;
+            }
+            for (; x < job->width; x++) {
+                const uint8_t *px = row + (size_t)x * 3;
+                sub[0][px[0]]++;
+                sub[0][256 + px[1]]++;
+                sub[0][512 + px[2]]++;
+            }
+            // Luma of the row while it is still in cache, a chunk at a time
+            for (int x0 = 0; job->with_luma && x0 < job->width; x0 += HISTOGRAM_LUMA_CHUNK) {
+                int n = job->width - x0 < HISTOGRAM_LUMA_CHUNK ? job->width - x0 : HISTOGRAM_LUMA_CHUNK;
+                const t_rgb_pixel *rgb = (const t_rgb_pixel *)row + x0;
+                if (job->bgr) {
+                    for (int i = 0; i < n; i++) {
+                        swapped[i].red = rgb[i].blue;
+                        swapped[i].green = rgb[i].green;
+                        swapped[i].blue = rgb[i].red;
+                    }
+                    rgb = swapped;
+                }
+                rgb_row_to_luma(rgb, luma, n);
+                for (int i = 0; i < n; i++) sub[i & 1][768 + luma[i]]++;
+            }
+        } else {
+            for (; x < job->width; x++) {
+                uint32_t *h = sub[x % HISTOGRAM_WAYS];
+                const uint8_t *px = row + (size_t)x * job->channels;
+                for (int c = 0; c < job->channels; c++) h[c * 256 + px[c]]++;
+            }
+        }
+    }
+
+    for (int i = 0; i < bins; i++) {
+        out[i] += sub[0][i] + sub[1][i] + sub[2][i] + sub[3][i];
+    }
+}
+
+// Part k covers rows [k * height / num_parts, (k + 1) * height / num_parts)
+static void histogram_parts(int begin, int end, void *ctx) {
+    const t_histogram_job *job = (const t_histogram_job *)ctx;
+    for (int k = begin; k < end; k++) {
+        int row_begin = (int)((long long)k * job->height / job->num_parts);
+        int row_end = (int)((long long)(k + 1) * job->height / job->num_parts);
+        histogram_count_rows(job, row_begin, row_end, job->partials + (size_t)k * (job->channels + job->with_luma) * 256);
+    }
+}
+
+// Splits the rows between threads and merges the parts into `hist`
+static void histogram_run(t_histogram_job *job, unsigned int *hist) {
+    int width = job->width, height = job->height;
+    int bins = (job->channels + job->with_luma) * 256;
+    size_t bytes = (size_t)width * height * job->channels;
+    job->num_parts = 1;
+    job->partials = NULL;
+    if (bytes >= HISTOGRAM_PARALLEL_MIN) {
+        job->num_parts = get_num_threads() < height ? get_num_threads() : height;
+    }
+
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    if (job->num_parts > 1) {
+        job->partials = (unsigned int *)arena_calloc(arena, (size_t)job->num_parts * bins, sizeof(unsigned int));
+    }
+    if (!job->partials) {
+        histogram_count_rows(job, 0, height, hist);
+        return;
+    }
+
+    parallel_for(0, job->num_parts, histogram_parts, job);
+    for (int k = 0; k < job->num_parts; k++) {
+        const unsigned int *part = job->partials + (size_t)k * bins;
+        for (int i = 0; i < bins; i++) hist[i] += part[i];
+    }
+    arena_release(arena, mark);
+}
+
+void histogram_count_u8(const uint8_t *src, int width, int height, size_t stride, int channels, unsigned int *hist) {
+    if (!src || !hist || width <= 0 || height <= 0 || channels < 1 || channels > HISTOGRAM_MAX_CHANNELS) return;
+
+    t_histogram_job job = {src, width, height, stride, channels, 0, 1, NULL, 0};
+    histogram_run(&job, hist);
+}
+
+void histogram_count_flat_u8(const uint8_t *data, size_t n, unsigned int *hist) {
+    if (!data || !hist) return;
+    size_t rows = n / HISTOGRAM_FLAT_ROW;
+    size_t tail = n % HISTOGRAM_FLAT_ROW;
+    if (rows) histogram_count_u8(data, HISTOGRAM_FLAT_ROW, (int)rows, HISTOGRAM_FLAT_ROW, 1, hist);
+    if (tail) histogram_count_u8(data + rows * HISTOGRAM_FLAT_ROW, (int)tail, 1, tail, 1, hist);
+}
+
 // --- 8-bit Grayscale Histogram Equalization ---
 
 unsigned int *bmp8_computeHistogram(t_bmp8 *img) {
@@ -11,22 +155,18 @@ unsigned int *bmp8_computeHistogram(t_bmp8 *img) {
         return NULL;
     }
 
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        hist[img->data[i]]++;
+    if (img->mappedRowSize) {
+        // Mapped rows still padded: counted where they are
+        histogram_count_u8(img->data, (int)img->width, (int)img->height, img->mappedRowSize, 1, hist);
+    } else {
+        histogram_count_flat_u8(img->data, img->dataSize, hist);
     }
     return hist;
 }
 
-unsigned int *bmp8_computeAndNormalizeCDF(const unsigned int *hist, unsigned int N_pixels) {
-    if (!hist || N_pixels == 0) return NULL;
-
-    unsigned int *cdf = (unsigned int *)calloc(256, sizeof(unsigned int));
-    unsigned int *hist_eq = (unsigned int *)calloc(256, sizeof(unsigned int));
-    if (!cdf || !hist_eq) {
-        perror("Failed to allocate memory for CDF/hist_eq");
-        free(cdf); free(hist_eq);
-        return NULL;
-    }
+// bmp8_computeAndNormalizeCDF into a caller-provided map of 256 entries
+static void equalization_map(const unsigned int *hist, unsigned int N_pixels, unsigned int *hist_eq) {
+    unsigned int cdf[256];
 
     // Compute CDF
     cdf[0] = hist[0];
@@ -98,66 +238,156 @@ unsigned int *bmp8_computeAndNormalizeCDF(const unsigned int *hist, unsigned int
             hist_eq[i] = clamp_int(hist_eq[i], 0, 255);
         }
     }
-
-    free(cdf);
-    return hist_eq;
 }
 
-void bmp8_equalize(t_bmp8 *img) {
-    if (!img || !img->data) return;
-
-    unsigned int *hist = bmp8_computeHistogram(img);
-    if (!hist) return;
+unsigned int *bmp8_computeAndNormalizeCDF(const unsigned int *hist, unsigned int N_pixels) {
+    if (!hist || N_pixels == 0) return NULL;
 
-    unsigned int N_pixels = img->dataSize; // For 8-bit, dataSize is number of pixels
-    unsigned int *hist_eq_map = bmp8_computeAndNormalizeCDF(hist, N_pixels);
-    if (!hist_eq_map) {
-        free(hist);
-        return;
+    unsigned int *hist_eq = (unsigned int *)calloc(256, sizeof(unsigned int));
+    if (!hist_eq) {
+        perror("Failed to allocate memory for CDF/hist_eq");
+        return NULL;
     }
+    equalization_map(hist, N_pixels, hist_eq);
+    return hist_eq;
+}
+
+// Equalizes n contiguous 8-bit values on their own histogram. Returns 0 on success.
+static int equalize_plane_u8(uint8_t *data, size_t n) {
+    if (n == 0) return 1;
+    // The tables are small enough for the stack
+    unsigned int hist[256] = {0};
+    unsigned int hist_eq_map[256];
+    histogram_count_flat_u8(data, n, hist);
+    equalization_map(hist, (unsigned int)n, hist_eq_map);
 
     // Apply the equalization map
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        img->data[i] = (unsigned char)hist_eq_map[img->data[i]];
-    }
+    uint8_t table[256];
+    for (int v = 0; v < 256; v++) table[v] = (uint8_t)hist_eq_map[v];
+    u8_lut(data, n, table);
+    return 0;
+}
 
-    free(hist);
-    free(hist_eq_map);
+void bmp8_equalize(t_bmp8 *img) {
+    if (!img || !img->data || bmp8_makeWritable(img) != 0) return;
+
+    // For 8-bit, dataSize is the number of pixels
+    if (equalize_plane_u8(img->data, img->dataSize) != 0) return;
     printf("8-bit Histogram equalization applied.\n");
 }
 
+void planar24_equalize(t_planar24 *img) {
+    if (!img) return;
+    for (int c = 0; c < PLANAR24_PLANES; c++) {
+        if (equalize_plane_u8(img->planes[c], (size_t)img->width * img->height) != 0) return;
+    }
+}
+
 
 // --- 24-bit Color Histogram Equalization ---
 
-t_yuv_pixel rgb_to_yuv(t_rgb_pixel rgb) {
-    t_yuv_pixel yuv;
-    float r = rgb.red;
-    float g = rgb.green;
-    float b = rgb.blue;
+// clamp_int((int)roundf(v), 0, 255) without the two library calls per channel.
+// v + 0.5 is exact in double precision, so truncating it rounds halves away
+// from zero like roundf for every v >= 0, and anything negative clamps to 0.
+static inline uint8_t round_to_u8(float v) {
+    double r = (double)v + 0.5;
+    if (r < 1.0) return 0;
+    if (r >= 255.0) return 255;
+    return (uint8_t)r;
+}
+
+// Y component alone, shared with rgb_to_yuv so both give the same float
+static inline float channels_luma(float r, float g, float b) {
+    return 0.299f * r + 0.587f * g + 0.114f * b;
+}
 
-    yuv.y = 0.299f * r + 0.587f * g + 0.114f * b;
+// rgb_to_yuv / yuv_to_rgb on separate channels: the row loops below inline
+// these instead of packing every pixel into a t_rgb_pixel for a call
+static inline t_yuv_pixel channels_to_yuv(float r, float g, float b) {
+    t_yuv_pixel yuv;
+    yuv.y = channels_luma(r, g, b);
     yuv.u = -0.14713f * r - 0.28886f * g + 0.436f * b;
     yuv.v = 0.615f * r - 0.51499f * g - 0.10001f * b;
     return yuv;
 }
 
+// Writes R, G, B to rgb[0..2]
+static inline void yuv_to_channels(t_yuv_pixel yuv, uint8_t *rgb) {
+    float r = yuv.y + 1.13983f * yuv.v;
+    float g = yuv.y - 0.39465f * yuv.u - 0.58060f * yuv.v;
+    float b = yuv.y + 2.03211f * yuv.u;
+
+    rgb[0] = round_to_u8(r);
+    rgb[1] = round_to_u8(g);
+    rgb[2] = round_to_u8(b);
+}
+
+t_yuv_pixel rgb_to_yuv(t_rgb_pixel rgb) {
+    return channels_to_yuv(rgb.red, rgb.green, rgb.blue);
+}
+
 t_rgb_pixel yuv_to_rgb(t_yuv_pixel yuv) {
-    t_rgb_pixel rgb;
-    float y_val = yuv.y;
-    float u_val = yuv.u;
-    float v_val = yuv.v;
-
-    float r = y_val + 1.13983f * v_val;
-    float g = y_val - 0.39465f * u_val - 0.58060f * v_val;
-    float b = y_val + 2.03211f * u_val;
-
-    rgb.red = (uint8_t)clamp_int((int)roundf(r), 0, 255);
-    rgb.green = (uint8_t)clamp_int((int)roundf(g), 0, 255);
-    rgb.blue = (uint8_t)clamp_int((int)roundf(b), 0, 255);
+    uint8_t channels[3];
+    yuv_to_channels(yuv, channels);
+    t_rgb_pixel rgb = {channels[0], channels[1], channels[2]};
     return rgb;
 }
 
 
+// --- Batch YUV conversion (fixed point) ---
+
+// Coefficients of rgb_to_yuv / yuv_to_rgb rounded to fixed point
+#define FIXED_COEF(c, bits) ((int32_t)((c) * (1 << (bits)) + ((c) >= 0 ? 0.5 : -0.5)))
+#define TO_YUV_BITS 14
+#define TO_RGB_BITS 13
+
+static const int32_t YR = FIXED_COEF(0.299, TO_YUV_BITS);
+static const int32_t YG = FIXED_COEF(0.587, TO_YUV_BITS);
+static const int32_t YB = FIXED_COEF(0.114, TO_YUV_BITS);
+static const int32_t UR = FIXED_COEF(-0.14713, TO_YUV_BITS);
+static const int32_t UG = FIXED_COEF(-0.28886, TO_YUV_BITS);
+static const int32_t UB = FIXED_COEF(0.436, TO_YUV_BITS);
+static const int32_t VR = FIXED_COEF(0.615, TO_YUV_BITS);
+static const int32_t VG = FIXED_COEF(-0.51499, TO_YUV_BITS);
+static const int32_t VB = FIXED_COEF(-0.10001, TO_YUV_BITS);
+static const int32_t RV = FIXED_COEF(1.13983, TO_RGB_BITS);
+static const int32_t GU = FIXED_COEF(-0.39465, TO_RGB_BITS);
+static const int32_t GV = FIXED_COEF(-0.58060, TO_RGB_BITS);
+static const int32_t BU = FIXED_COEF(2.03211, TO_RGB_BITS);
+
+static inline uint8_t clamp_u8(int32_t v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+void rgb_row_to_luma(const t_rgb_pixel *src, uint8_t *y, int width) {
+    for (int x = 0; x < width; x++) {
+        // The Y weights sum to exactly 1 << TO_YUV_BITS, so the result stays in 0..255
+        y[x] = (uint8_t)((YR * src[x].red + YG * src[x].green + YB * src[x].blue + (1 << (TO_YUV_BITS - 1))) >> TO_YUV_BITS);
+    }
+}
+
+void rgb_row_to_yuv(const t_rgb_pixel *src, uint8_t *y, int16_t *u, int16_t *v, int width) {
+    const int shift = TO_YUV_BITS - YUV_CHROMA_SHIFT;
+    rgb_row_to_luma(src, y, width);
+    for (int x = 0; x < width; x++) {
+        int32_t r = src[x].red, g = src[x].green, b = src[x].blue;
+        u[x] = (int16_t)((UR * r + UG * g + UB * b + (1 << (shift - 1))) >> shift);
+        v[x] = (int16_t)((VR * r + VG * g + VB * b + (1 << (shift - 1))) >> shift);
+    }
+}
+
+void yuv_row_to_rgb(const uint8_t *y, const int16_t *u, const int16_t *v, t_rgb_pixel *dst, int width) {
+    // Y << shift and the U/V products share the same scale (TO_RGB_BITS + YUV_CHROMA_SHIFT)
+    const int shift = TO_RGB_BITS + YUV_CHROMA_SHIFT;
+    const int32_t half = 1 << (shift - 1);
+    for (int x = 0; x < width; x++) {
+        int32_t luma = ((int32_t)y[x] << shift) + half;
+        dst[x].red = clamp_u8((luma + RV * v[x]) >> shift);
+        dst[x].green = clamp_u8((luma + GU * u[x] + GV * v[x]) >> shift);
+        dst[x].blue = clamp_u8((luma + BU * u[x]) >> shift);
+    }
+}
+
 unsigned int *compute_y_channel_histogram(const uint8_t *y_channel_data, unsigned int num_pixels) {
     if (!y_channel_data) return NULL;
     unsigned int *hist = (unsigned int *)calloc(256, sizeof(unsigned int));
@@ -165,92 +395,454 @@ unsigned int *compute_y_channel_histogram(const uint8_t *y_channel_data, unsigne
         perror("Failed to allocate Y-channel histogram");
         return NULL;
     }
-    for (unsigned int i = 0; i < num_pixels; i++) {
-        hist[y_channel_data[i]]++;
+    histogram_count_flat_u8(y_channel_data, num_pixels, hist);
+    return hist;
+}
+
+// Mapped images can still be in file order (B,G,R; row order does not matter
+// here): their red and blue tables come out swapped
+static void bgr_swap_tables(unsigned int *hist) {
+    for (int v = 0; v < 256; v++) {
+        unsigned int t = hist[v];
+        hist[v] = hist[512 + v];
+        hist[512 + v] = t;
+    }
+}
+
+unsigned int *bmp24_computeHistograms(t_bmp24 *img) {
+    if (!img || !img->pixels) return NULL;
+    unsigned int *hist = (unsigned int *)calloc(3 * 256, sizeof(unsigned int));
+    if (!hist) {
+        perror("Failed to allocate RGB histograms");
+        return NULL;
+    }
+    histogram_count_u8(img->pixels, img->info.width, abs(img->info.height), img->stride, 3, hist);
+    if (img->fileLayout) bgr_swap_tables(hist);
+    return hist;
+}
+
+unsigned int *bmp32_computeHistograms(t_bmp32 *img) {
+    if (!img || !img->pixels) return NULL;
+    unsigned int *hist = (unsigned int *)calloc(4 * 256, sizeof(unsigned int));
+    if (!hist) {
+        perror("Failed to allocate RGBA histograms");
+        return NULL;
     }
+    histogram_count_u8(img->pixels, img->info.width, abs(img->info.height), img->stride, 4, hist);
     return hist;
 }
 
+t_bmp24_stats *bmp24_computeStats(t_bmp24 *img) {
+    if (!img || !img->pixels) return NULL;
+    t_bmp24_stats *stats = (t_bmp24_stats *)calloc(1, sizeof(t_bmp24_stats));
+    if (!stats) {
+        perror("Failed to allocate image statistics");
+        return NULL;
+    }
 
-void bmp24_equalize(t_bmp24 *img) {
-    if (!img || !img->data) return;
+    // One pass over the pixels fills the four histograms, everything else follows from them
+    int width = img->info.width, height = abs(img->info.height);
+    t_histogram_job job = {img->pixels, width, height, img->stride, 3, 1, 1, NULL, img->fileLayout};
+    histogram_run(&job, &stats->hist[0][0]);
+    if (img->fileLayout) bgr_swap_tables(&stats->hist[0][0]);
+    stats->num_pixels = (unsigned int)width * height;
+
+    for (int c = 0; c < STATS_CHANNELS; c++) {
+        const unsigned int *h = stats->hist[c];
+        double sum = 0, sum_sq = 0;
+        int lo = 255, hi = 0;
+        for (int v = 0; v < 256; v++) {
+            if (!h[v]) continue;
+            if (v < lo) lo = v;
+            hi = v;
+            sum += (double)h[v] * v;
+            sum_sq += (double)h[v] * v * v;
+        }
+        if (stats->num_pixels == 0) continue;
+        double mean = sum / stats->num_pixels;
+        double variance = sum_sq / stats->num_pixels - mean * mean;
+        stats->min[c] = (uint8_t)lo;
+        stats->max[c] = (uint8_t)hi;
+        stats->mean[c] = mean;
+        stats->stddev[c] = variance > 0 ? sqrt(variance) : 0;
+    }
+    return stats;
+}
 
-    int width = img->info.width;
-    int height = abs(img->info.height);
-    unsigned int num_pixels = width * height;
+void bmp24_printStats(const t_bmp24_stats *stats) {
+    if (!stats) return;
+    const char *names[STATS_CHANNELS] = {"Red", "Green", "Blue", "Luma"};
+    printf("Image statistics (%u pixels):\n", stats->num_pixels);
+    for (int c = 0; c < STATS_CHANNELS; c++) {
+        printf("  %-5s min %3d  max %3d  mean %7.2f  stddev %7.2f\n",
+               names[c], stats->min[c], stats->max[c], stats->mean[c], stats->stddev[c]);
+    }
+}
+
+
+// Luma of the R, G, B bytes at px as the 8-bit histogram bin it falls into
+static inline uint8_t luma_bin_at(const uint8_t *px) {
+    return round_to_u8(channels_luma(px[0], px[1], px[2]));
+}
 
-    // 1. Convert RGB to YUV and store Y channel (as uint8_t) and U,V (as float)
-    t_yuv_pixel **yuv_image = (t_yuv_pixel **)malloc(height * sizeof(t_yuv_pixel *));
-    uint8_t *y_channel_data_for_hist = (uint8_t *)malloc(num_pixels * sizeof(uint8_t));
+// R, G, B at the start of a 3-byte (t_bmp24) or 4-byte (t_bmp32) pixel
+static inline t_rgb_pixel rgb_at(const uint8_t *px) {
+    t_rgb_pixel rgb = {px[0], px[1], px[2]};
+    return rgb;
+}
 
-    if (!yuv_image || !y_channel_data_for_hist) {
-        perror("Failed to allocate memory for YUV conversion");
-        free(yuv_image); // One might be non-NULL
-        free(y_channel_data_for_hist);
+typedef struct {
+    uint8_t *pixels;
+    int width;
+    size_t stride;
+    const unsigned int *y_map; // Equalized luma for every histogram bin
+} t_equalize_job;
+
+// Second pass over rows [begin, end): replace Y with its equalized value and
+// rebuild RGB. Each row goes through Y, U, V float rows of the thread's scratch
+// arena, one loop per step, so the conversions run over plain float arrays.
+// Called with a literal bpp so each pixel size gets its own fixed-step loop.
+static inline void equalize_remap(const t_equalize_job *job, int begin, int end, int bpp) {
+    // Byte stores may alias *job, so the fields are read once outside the loops
+    const unsigned int *y_map = job->y_map;
+    int width = job->width;
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    float *y_row = (float *)arena_alloc(arena, width * sizeof(float));
+    float *u_row = (float *)arena_alloc(arena, width * sizeof(float));
+    float *v_row = (float *)arena_alloc(arena, width * sizeof(float));
+    if (!y_row || !u_row || !v_row) {
+        perror("Failed to allocate equalization row buffers");
+        arena_release(arena, mark);
         return;
     }
-    for(int i=0; i<height; ++i) {
-        yuv_image[i] = (t_yuv_pixel*)malloc(width * sizeof(t_yuv_pixel));
-        if(!yuv_image[i]){
-            perror("Failed to allocate memory for YUV row");
-            for(int k=0; k<i; ++k) free(yuv_image[k]);
-            free(yuv_image);
-            free(y_channel_data_for_hist);
-            return;
+    for (int y = begin; y < end; y++) {
+        uint8_t *row = job->pixels + (size_t)y * job->stride;
+        for (int x = 0; x < width; x++) {
+            t_yuv_pixel yuv = channels_to_yuv(row[x * bpp], row[x * bpp + 1], row[x * bpp + 2]);
+            y_row[x] = yuv.y;
+            u_row[x] = yuv.u;
+            v_row[x] = yuv.v;
+        }
+        for (int x = 0; x < width; x++) {
+            y_row[x] = (float)y_map[round_to_u8(y_row[x])];
+        }
+        for (int x = 0; x < width; x++) {
+            t_yuv_pixel yuv = {y_row[x], u_row[x], v_row[x]};
+            yuv_to_channels(yuv, row + x * bpp);
         }
     }
+    arena_release(arena, mark);
+}
 
+static void equalize_remap_rows3(int begin, int end, void *ctx) {
+    equalize_remap((const t_equalize_job *)ctx, begin, end, 3);
+}
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            yuv_image[y][x] = rgb_to_yuv(img->data[y][x]);
-            // Clamp Y for histogram, but keep original float Y for reconstruction
-            y_channel_data_for_hist[y * width + x] = (uint8_t)clamp_int((int)roundf(yuv_image[y][x].y), 0, 255);
+static void equalize_remap_rows4(int begin, int end, void *ctx) {
+    equalize_remap((const t_equalize_job *)ctx, begin, end, 4);
+}
+
+typedef struct {
+    const uint8_t *pixels;
+    int width;
+    int height;
+    size_t stride;
+    int num_parts;
+    unsigned int *partials;    // 256 bins per part
+} t_luma_hist_job;
+
+// Luma histogram of parts [begin, end), part k covering rows [k * height / num_parts, ...)
+static inline void equalize_luma(const t_luma_hist_job *job, int begin, int end, int bpp) {
+    for (int k = begin; k < end; k++) {
+        int row_begin = (int)((long long)k * job->height / job->num_parts);
+        int row_end = (int)((long long)(k + 1) * job->height / job->num_parts);
+        unsigned int *hist = job->partials + (size_t)k * 256;
+        for (int y = row_begin; y < row_end; y++) {
+            const uint8_t *px = job->pixels + (size_t)y * job->stride;
+            for (int x = 0; x < job->width; x++, px += bpp) {
+                hist[luma_bin_at(px)]++;
+            }
         }
     }
+}
 
-    // 2. Calculate histogram of the Y component
-    unsigned int *y_hist = compute_y_channel_histogram(y_channel_data_for_hist, num_pixels);
-    if (!y_hist) {
-        // Free YUV image data
-        for(int i=0; i<height; ++i) free(yuv_image[i]);
-        free(yuv_image);
-        free(y_channel_data_for_hist);
-        return;
+static void equalize_luma_parts3(int begin, int end, void *ctx) {
+    equalize_luma((const t_luma_hist_job *)ctx, begin, end, 3);
+}
+
+static void equalize_luma_parts4(int begin, int end, void *ctx) {
+    equalize_luma((const t_luma_hist_job *)ctx, begin, end, 4);
+}
+
+// Equalization of the luma of an RGB or RGBA buffer. Returns 0 on success.
+static int equalize_rgb_u8(uint8_t *pixels, int width, int height, size_t stride, int bpp) {
+    unsigned int num_pixels = width * height;
+
+    // 1. Histogram of the Y component, straight from the RGB pixels: one part
+    //    per thread on large images, merged afterwards
+    t_luma_hist_job hist_job = {pixels, width, height, stride, 1, NULL};
+    if ((size_t)width * height * bpp >= HISTOGRAM_PARALLEL_MIN) {
+        hist_job.num_parts = get_num_threads() < height ? get_num_threads() : height;
+    }
+    if (num_pixels == 0) return 1;
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    hist_job.partials = (unsigned int *)arena_calloc(arena, (size_t)hist_job.num_parts * 256, sizeof(unsigned int));
+    if (!hist_job.partials) {
+        perror("Failed to allocate Y-channel histogram");
+        return 1;
+    }
+    parallel_for(0, hist_job.num_parts, (bpp == 3) ? equalize_luma_parts3 : equalize_luma_parts4, &hist_job);
+    unsigned int y_hist[256] = {0};
+    for (int k = 0; k < hist_job.num_parts; k++) {
+        for (int i = 0; i < 256; i++) y_hist[i] += hist_job.partials[(size_t)k * 256 + i];
     }
+    arena_release(arena, mark);
 
-    // 3. Calculate cumulative histogram (CDF) and normalize for Y
-    unsigned int *y_hist_eq_map = bmp8_computeAndNormalizeCDF(y_hist, num_pixels); // Re-use 8-bit CDF logic
-    if (!y_hist_eq_map) {
-        free(y_hist);
-        for(int i=0; i<height; ++i) free(yuv_image[i]);
-        free(yuv_image);
-        free(y_channel_data_for_hist);
-        return;
+    // 2. Calculate cumulative histogram (CDF) and normalize for Y
+    unsigned int y_hist_eq_map[256];
+    equalization_map(y_hist, num_pixels, y_hist_eq_map); // Re-use 8-bit CDF logic
+
+    // 3. Equalize Y and convert back to RGB in one pass, without a YUV copy of the image
+    t_equalize_job job = {pixels, width, stride, y_hist_eq_map};
+    parallel_for(0, height, (bpp == 3) ? equalize_remap_rows3 : equalize_remap_rows4, &job);
+    return 0;
+}
+
+void bmp24_equalize(t_bmp24 *img) {
+    if (!img || !img->data || bmp24_makeWritable(img) != 0) return;
+    if (equalize_rgb_u8(img->pixels, img->info.width, abs(img->info.height), img->stride, 3) != 0) return;
+    printf("24-bit Color Histogram equalization (on Y channel) applied.\n");
+}
+
+void bmp32_equalize(t_bmp32 *img) {
+    if (!img || !img->data) return;
+    if (equalize_rgb_u8(img->pixels, img->info.width, abs(img->info.height), img->stride, 4) != 0) return;
+    printf("32-bit Color Histogram equalization (on Y channel) applied.\n");
+}
+
+
+// --- Contrast-Limited Adaptive Histogram Equalization (CLAHE) ---
+
+typedef struct {
+    uint8_t *plane;
+    int width, height;
+    size_t stride;
+    int tiles_x, tiles_y;
+    float clip_limit;
+    uint8_t *maps;           // tiles_x * tiles_y mappings of 256 entries
+    const int *col_tile;     // Left neighbouring tile of each column
+    const float *col_weight; // Weight of the right neighbour for each column
+} t_clahe_job;
+
+// Tile i covers [i * size / tiles, (i + 1) * size / tiles)
+static int clahe_tile_start(int i, int size, int tiles) {
+    return (int)((long long)i * size / tiles);
+}
+
+// Clips the histogram at `limit` and spreads the excess over all bins
+static void clahe_clip_histogram(unsigned int *hist, unsigned int limit) {
+    unsigned int excess = 0;
+    for (int v = 0; v < 256; v++) {
+        if (hist[v] > limit) {
+            excess += hist[v] - limit;
+            hist[v] = limit;
+        }
+    }
+    unsigned int share = excess / 256, rest = excess % 256;
+    for (int v = 0; v < 256; v++) hist[v] += share;
+    // Leftover counts go to evenly spaced bins
+    if (rest > 0) {
+        unsigned int step = 256 / rest;
+        for (unsigned int v = 0; v < 256 && rest > 0; v += step, rest--) hist[v]++;
     }
+}
 
-    // 4. Apply histogram equalization to the Y component (using the original float Y values)
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            uint8_t original_y_clamped = (uint8_t)clamp_int((int)roundf(yuv_image[y][x].y), 0, 255);
-            yuv_image[y][x].y = (float)y_hist_eq_map[original_y_clamped];
-            // Ensure Y is still in a valid float range if needed, though map should keep it 0-255
+// Histogram, clipping and CDF mapping of tiles [begin, end)
+static void clahe_tile_maps(int begin, int end, void *ctx) {
+    const t_clahe_job *job = (const t_clahe_job *)ctx;
+    for (int t = begin; t < end; t++) {
+        int tx = t % job->tiles_x, ty = t / job->tiles_x;
+        int x0 = clahe_tile_start(tx, job->width, job->tiles_x), x1 = clahe_tile_start(tx + 1, job->width, job->tiles_x);
+        int y0 = clahe_tile_start(ty, job->height, job->tiles_y), y1 = clahe_tile_start(ty + 1, job->height, job->tiles_y);
+        unsigned int tile_pixels = (unsigned int)(x1 - x0) * (y1 - y0);
+
+        // Counted on this thread: the tiles are already spread over the pool
+        unsigned int hist[256] = {0};
+        t_histogram_job count = {job->plane + (size_t)y0 * job->stride + x0, x1 - x0, y1 - y0, job->stride, 1, 0, 1, NULL, 0};
+        histogram_count_rows(&count, 0, y1 - y0, hist);
+
+        if (job->clip_limit > 0) {
+            float limit = job->clip_limit * tile_pixels / 256.0f;
+            clahe_clip_histogram(hist, limit < 1.0f ? 1u : (unsigned int)limit);
         }
+
+        unsigned int map[256];
+        equalization_map(hist, tile_pixels, map);
+        uint8_t *out = job->maps + (size_t)t * 256;
+        for (int v = 0; v < 256; v++) out[v] = (uint8_t)map[v];
     }
+}
 
-    // 5. Convert Y'UV back to RGB
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            img->data[y][x] = yuv_to_rgb(yuv_image[y][x]);
+// Bilinear blend of the four surrounding tile mappings for rows [begin, end)
+static void clahe_interpolate_rows(int begin, int end, void *ctx) {
+    const t_clahe_job *job = (const t_clahe_job *)ctx;
+    float tile_h = (float)job->height / job->tiles_y;
+    for (int y = begin; y < end; y++) {
+        float gy = (y + 0.5f) / tile_h - 0.5f;
+        int ty0 = gy < 0 ? 0 : (int)gy;
+        if (ty0 > job->tiles_y - 1) ty0 = job->tiles_y - 1;
+        int ty1 = ty0 + 1 < job->tiles_y ? ty0 + 1 : ty0;
+        float wy = clamp_float(gy - ty0, 0.0f, 1.0f);
+
+        const uint8_t *top = job->maps + (size_t)ty0 * job->tiles_x * 256;
+        const uint8_t *bottom = job->maps + (size_t)ty1 * job->tiles_x * 256;
+        uint8_t *row = job->plane + (size_t)y * job->stride;
+        for (int x = 0; x < job->width; x++) {
+            int tx0 = job->col_tile[x];
+            int tx1 = tx0 + 1 < job->tiles_x ? tx0 + 1 : tx0;
+            float wx = job->col_weight[x];
+            int v = row[x];
+            float upper = top[tx0 * 256 + v] + wx * (top[tx1 * 256 + v] - top[tx0 * 256 + v]);
+            float lower = bottom[tx0 * 256 + v] + wx * (bottom[tx1 * 256 + v] - bottom[tx0 * 256 + v]);
+            row[x] = (uint8_t)(upper + wy * (lower - upper) + 0.5f);
         }
     }
+}
 
-    // Cleanup
-    free(y_hist);
-    free(y_hist_eq_map);
-    for(int i=0; i<height; ++i) free(yuv_image[i]);
-    free(yuv_image);
-    free(y_channel_data_for_hist);
+// CLAHE on one 8-bit plane, in place. Returns 0 on success.
+static int clahe_u8(uint8_t *plane, int width, int height, size_t stride, int tiles_x, int tiles_y, float clip_limit) {
+    tiles_x = clamp_int(tiles_x, 1, width);
+    tiles_y = clamp_int(tiles_y, 1, height);
+    int num_tiles = tiles_x * tiles_y;
+
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    uint8_t *maps = (uint8_t *)arena_alloc(arena, (size_t)num_tiles * 256);
+    int *col_tile = (int *)arena_alloc(arena, width * sizeof(int));
+    float *col_weight = (float *)arena_alloc(arena, width * sizeof(float));
+    if (!maps || !col_tile || !col_weight) {
+        perror("Failed to allocate CLAHE tables");
+        arena_release(arena, mark);
+        return 1;
+    }
 
-    printf("24-bit Color Histogram equalization (on Y channel) applied.\n");
+    // Position of every column between the tile centers
+    float tile_w = (float)width / tiles_x;
+    for (int x = 0; x < width; x++) {
+        float gx = (x + 0.5f) / tile_w - 0.5f;
+        int tx = gx < 0 ? 0 : (int)gx;
+        if (tx > tiles_x - 1) tx = tiles_x - 1;
+        col_tile[x] = tx;
+        col_weight[x] = clamp_float(gx - tx, 0.0f, 1.0f);
+    }
+
+    t_clahe_job job = {plane, width, height, stride, tiles_x, tiles_y, clip_limit, maps, col_tile, col_weight};
+    parallel_for(0, num_tiles, clahe_tile_maps, &job);
+    parallel_for(0, height, clahe_interpolate_rows, &job);
+
+    arena_release(arena, mark);
+    return 0;
+}
+
+void bmp8_clahe(t_bmp8 *img, int tiles_x, int tiles_y, float clip_limit) {
+    if (!img || !img->data || img->width == 0 || img->height == 0 || bmp8_makeWritable(img) != 0) return;
+    if (clahe_u8(img->data, img->width, img->height, img->width, tiles_x, tiles_y, clip_limit) != 0) return;
+    printf("8-bit CLAHE applied (%dx%d tiles, clip limit %.1f).\n", tiles_x, tiles_y, clip_limit);
+}
+
+typedef struct {
+    uint8_t *pixels;
+    int width;
+    size_t stride;
+    int bpp;        // 3, or 4 with alpha left as it is
+    uint8_t *luma;  // Equalized luma plane, width * height
+} t_clahe_rgb_job;
+
+// Row of the image as t_rgb_pixel: the row itself for 3-byte pixels, a copy
+// of the R, G, B bytes in `buffer` for 4-byte pixels
+static t_rgb_pixel *clahe_rgb_row(const t_clahe_rgb_job *job, int y, t_rgb_pixel *buffer) {
+    uint8_t *px = job->pixels + (size_t)y * job->stride;
+    if (job->bpp == 3) return (t_rgb_pixel *)px;
+    for (int x = 0; x < job->width; x++, px += job->bpp) buffer[x] = rgb_at(px);
+    return buffer;
+}
+
+static void clahe_rgb_luma_rows(int begin, int end, void *ctx) {
+    const t_clahe_rgb_job *job = (const t_clahe_rgb_job *)ctx;
+    int width = job->width;
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    t_rgb_pixel *buffer = (job->bpp == 3) ? NULL : (t_rgb_pixel *)arena_alloc(arena, width * sizeof(t_rgb_pixel));
+    if (job->bpp != 3 && !buffer) {
+        perror("Failed to allocate CLAHE row buffer");
+        return;
+    }
+    for (int y = begin; y < end; y++) {
+        rgb_row_to_luma(clahe_rgb_row(job, y, buffer), job->luma + (size_t)y * width, width);
+    }
+    arena_release(arena, mark);
+}
+
+// Swaps each row's luma for the equalized one and rebuilds RGB
+static void clahe_rgb_rebuild_rows(int begin, int end, void *ctx) {
+    const t_clahe_rgb_job *job = (const t_clahe_rgb_job *)ctx;
+    int width = job->width;
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    uint8_t *y_row = (uint8_t *)arena_alloc(arena, width);
+    int16_t *u_row = (int16_t *)arena_alloc(arena, width * sizeof(int16_t));
+    int16_t *v_row = (int16_t *)arena_alloc(arena, width * sizeof(int16_t));
+    t_rgb_pixel *buffer = (job->bpp == 3) ? NULL : (t_rgb_pixel *)arena_alloc(arena, width * sizeof(t_rgb_pixel));
+    if (y_row && u_row && v_row && (job->bpp == 3 || buffer)) {
+        for (int y = begin; y < end; y++) {
+            t_rgb_pixel *rgb = clahe_rgb_row(job, y, buffer);
+            rgb_row_to_yuv(rgb, y_row, u_row, v_row, width);
+            yuv_row_to_rgb(job->luma + (size_t)y * width, u_row, v_row, rgb, width);
+            if (job->bpp == 3) continue;
+            uint8_t *px = job->pixels + (size_t)y * job->stride;
+            for (int x = 0; x < width; x++, px += job->bpp) {
+                px[0] = rgb[x].red;
+                px[1] = rgb[x].green;
+                px[2] = rgb[x].blue;
+            }
+        }
+    } else {
+        perror("Failed to allocate CLAHE row buffers");
+    }
+    arena_release(arena, mark);
+}
+
+// CLAHE on the luma of an RGB or RGBA buffer. Returns 0 on success.
+static int clahe_rgb_u8(uint8_t *pixels, int width, int height, size_t stride, int bpp,
+                        int tiles_x, int tiles_y, float clip_limit) {
+    if (width <= 0 || height <= 0) return 1;
+
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    t_clahe_rgb_job job = {pixels, width, stride, bpp, (uint8_t *)arena_alloc(arena, (size_t)width * height)};
+    if (!job.luma) {
+        perror("Failed to allocate luma plane");
+        return 1;
+    }
+    parallel_for(0, height, clahe_rgb_luma_rows, &job);
+    int status = clahe_u8(job.luma, width, height, width, tiles_x, tiles_y, clip_limit);
+    if (status == 0) parallel_for(0, height, clahe_rgb_rebuild_rows, &job);
+    arena_release(arena, mark);
+    return status;
+}
+
+void bmp24_clahe(t_bmp24 *img, int tiles_x, int tiles_y, float clip_limit) {
+    if (!img || !img->data || bmp24_makeWritable(img) != 0) return;
+    if (clahe_rgb_u8(img->pixels, img->info.width, abs(img->info.height), img->stride, 3,
+                     tiles_x, tiles_y, clip_limit) != 0) return;
+    printf("24-bit CLAHE (on Y channel) applied (%dx%d tiles, clip limit %.1f).\n", tiles_x, tiles_y, clip_limit);
+}
+
+void bmp32_clahe(t_bmp32 *img, int tiles_x, int tiles_y, float clip_limit) {
+    if (!img || !img->data) return;
+    if (clahe_rgb_u8(img->pixels, img->info.width, abs(img->info.height), img->stride, 4,
+                     tiles_x, tiles_y, clip_limit) != 0) return;
+    printf("32-bit CLAHE (on Y channel) applied (%dx%d tiles, clip limit %.1f).\n", tiles_x, tiles_y, clip_limit);
 }
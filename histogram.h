@@ -7,8 +7,25 @@
 
 #include "bmp8.h"  // For t_bmp8 and 8-bit operations
 #include "bmp24.h" // For t_bmp24 and 24-bit operations
+#include "bmp32.h" // For t_bmp32
+#include "planar.h" // For t_planar24 (planar24_equalize)
 #include "utils.h"
 
+// --- Histogram engine ---
+// Shared by the functions below. Rows are split between the threads of
+// parallel_for, and each part counts into interleaved sub-histograms before
+// the parts are merged.
+
+#define HISTOGRAM_MAX_CHANNELS 4
+
+// Adds the counts of an interleaved 8-bit image (channels values per pixel, rows
+// `stride` bytes apart) to `hist`: one table of 256 entries per channel, value v of
+// channel c counted in hist[c * 256 + v]. `hist` is not cleared first.
+void histogram_count_u8(const uint8_t *src, int width, int height, size_t stride, int channels, unsigned int *hist);
+
+// Same for a contiguous buffer of n single-channel values
+void histogram_count_flat_u8(const uint8_t *data, size_t n, unsigned int *hist);
+
 // --- 8-bit Grayscale Histogram Equalization ---
 
 // Computes the histogram of an 8-bit grayscale image.
@@ -41,14 +58,82 @@ t_yuv_pixel rgb_to_yuv(t_rgb_pixel rgb);
 // Converts a YUV pixel to RGB
 t_rgb_pixel yuv_to_rgb(t_yuv_pixel yuv);
 
+// --- Batch YUV conversion (fixed point) ---
+// Whole-row versions of rgb_to_yuv / yuv_to_rgb with integer coefficients, for
+// equalization or any filter that only works on luma. Y is stored as 0..255 and
+// U, V as signed values scaled by 2^YUV_CHROMA_SHIFT (|U| < 112, |V| < 157).
+//
+// Accuracy, measured over all 2^24 RGB colors:
+//   - rgb_row_to_luma matches roundf(rgb_to_yuv().y) except for 0.19% of colors, off by 1.
+//   - RGB -> YUV -> RGB: max error 1 per channel, 97.6% of colors come back exactly
+//     (the float pair is exact; the fixed error comes from rounding Y to 8 bits).
+//   - With Y replaced (as equalization does), yuv_row_to_rgb is within 1 of yuv_to_rgb,
+//     and differs for about 2% of pixels.
+#define YUV_CHROMA_SHIFT 7
+
+// Y component only, 0..255
+void rgb_row_to_luma(const t_rgb_pixel *src, uint8_t *y, int width);
+
+// Splits a row into Y, U and V planes
+void rgb_row_to_yuv(const t_rgb_pixel *src, uint8_t *y, int16_t *u, int16_t *v, int width);
+
+// Rebuilds a row from Y, U and V planes (clamped to 0..255)
+void yuv_row_to_rgb(const uint8_t *y, const int16_t *u, const int16_t *v, t_rgb_pixel *dst, int width);
+
 // Computes histogram for the Y component of a YUV image representation
 // y_channel_data: 1D array of Y component values (scaled to 0-255 uint8_t)
 // num_pixels: total number of pixels
 // Returns an array of 256 integers. Caller must free.
 unsigned int *compute_y_channel_histogram(const uint8_t *y_channel_data, unsigned int num_pixels);
 
+// Computes the histograms of the red, green and blue channels of a 24-bit image.
+// Returns an array of 3 * 256 integers (red, then green, then blue). Caller must free.
+unsigned int *bmp24_computeHistograms(t_bmp24 *img);
+
+// Same for a 32-bit image, with a fourth table for alpha (4 * 256 integers). Caller must free.
+unsigned int *bmp32_computeHistograms(t_bmp32 *img);
+
+// Histograms and summary statistics of a 24-bit image, indexed by t_stats_channel.
+// Luma is the 0..255 value of rgb_row_to_luma.
+typedef enum { STATS_RED, STATS_GREEN, STATS_BLUE, STATS_LUMA, STATS_CHANNELS } t_stats_channel;
+
+typedef struct {
+    unsigned int hist[STATS_CHANNELS][256];
+    uint8_t min[STATS_CHANNELS];
+    uint8_t max[STATS_CHANNELS];
+    double mean[STATS_CHANNELS];
+    double stddev[STATS_CHANNELS];  // Population standard deviation
+    unsigned int num_pixels;
+} t_bmp24_stats;
+
+// Computes all the statistics in a single pass over the image, split across threads by row bands.
+// Returns a t_bmp24_stats structure or NULL on error. Caller must free.
+t_bmp24_stats *bmp24_computeStats(t_bmp24 *img);
+
+// Prints min, max, mean and standard deviation of each channel
+void bmp24_printStats(const t_bmp24_stats *stats);
+
 // Applies histogram equalization to a 24-bit color image.
 void bmp24_equalize(t_bmp24 *img);
 
+// Same on the R, G, B channels of a 32-bit image (alpha is left as it is)
+void bmp32_equalize(t_bmp32 *img);
+
+
+// --- Contrast-Limited Adaptive Histogram Equalization (CLAHE) ---
+// The image is cut into tiles_x * tiles_y tiles, each equalized with its own
+// clipped histogram (bmp8_computeAndNormalizeCDF per tile); every pixel then
+// blends the mappings of the four nearest tiles. clip_limit is a multiple of the
+// average bin count of a tile (0 disables clipping, which is plain adaptive
+// equalization). The tiles and the rows are spread across threads.
+
+#define CLAHE_DEFAULT_TILES 8
+#define CLAHE_DEFAULT_CLIP_LIMIT 2.0f
+
+void bmp8_clahe(t_bmp8 *img, int tiles_x, int tiles_y, float clip_limit);
+
+// Works on the Y channel (rgb_row_to_yuv / yuv_row_to_rgb), colors are kept
+void bmp24_clahe(t_bmp24 *img, int tiles_x, int tiles_y, float clip_limit);
+void bmp32_clahe(t_bmp32 *img, int tiles_x, int tiles_y, float clip_limit); // Alpha is left as it is
 
 #endif // HISTOGRAM_H
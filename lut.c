@@ -0,0 +1,142 @@
+#include "lut.h"
+#include "pixelops.h"
+
+// Rows below this many bytes are mapped on the calling thread
+#define LUT_PARALLEL_MIN (1u << 20)
+
+void lut_init(t_lut *lut, int channels) {
+    if (!lut) return;
+    lut->channels = clamp_int(channels, 1, LUT_MAX_CHANNELS);
+    for (int c = 0; c < LUT_MAX_CHANNELS; c++) {
+        for (int v = 0; v < 256; v++) lut->table[c][v] = (uint8_t)v;
+    }
+}
+
+// Replaces every entry e of the selected channels with map[e]
+static void lut_compose(t_lut *lut, int channel, const uint8_t *map) {
+    if (!lut) return;
+    for (int c = 0; c < lut->channels; c++) {
+        if (channel != LUT_ALL_CHANNELS && channel != c) continue;
+        for (int v = 0; v < 256; v++) lut->table[c][v] = map[lut->table[c][v]];
+    }
+}
+
+void lut_negative(t_lut *lut) {
+    uint8_t map[256];
+    for (int v = 0; v < 256; v++) map[v] = (uint8_t)(255 - v);
+    lut_compose(lut, LUT_ALL_CHANNELS, map);
+}
+
+void lut_brightness(t_lut *lut, int value) {
+    uint8_t map[256];
+    value = clamp_int(value, -255, 255);
+    for (int v = 0; v < 256; v++) map[v] = (uint8_t)clamp_int(v + value, 0, 255);
+    lut_compose(lut, LUT_ALL_CHANNELS, map);
+}
+
+void lut_threshold(t_lut *lut, int threshold) {
+    uint8_t map[256];
+    threshold = clamp_int(threshold, 0, 255);
+    for (int v = 0; v < 256; v++) map[v] = (v >= threshold) ? 255 : 0;
+    lut_compose(lut, LUT_ALL_CHANNELS, map);
+}
+
+void lut_remap(t_lut *lut, int channel, const unsigned int *map) {
+    if (!map) return;
+    uint8_t clamped[256];
+    for (int v = 0; v < 256; v++) clamped[v] = (uint8_t)(map[v] > 255 ? 255 : map[v]);
+    lut_compose(lut, channel, clamped);
+}
+
+void lut_then(t_lut *lut, const t_lut *next) {
+    if (!lut || !next) return;
+    // A single-channel table applies to every channel
+    if (next->channels > lut->channels) {
+        for (int c = lut->channels; c < next->channels; c++) memcpy(lut->table[c], lut->table[0], 256);
+        lut->channels = next->channels;
+    }
+    for (int c = 0; c < lut->channels; c++) {
+        lut_compose(lut, c, next->table[next->channels == 1 ? 0 : c]);
+    }
+}
+
+int lut_is_identity(const t_lut *lut) {
+    if (!lut) return 1;
+    for (int c = 0; c < lut->channels; c++) {
+        for (int v = 0; v < 256; v++) {
+            if (lut->table[c][v] != v) return 0;
+        }
+    }
+    return 1;
+}
+
+// 1 if all channels share the same table (the buffer can then be swept as flat bytes)
+static int lut_is_uniform(const t_lut *lut) {
+    for (int c = 1; c < lut->channels; c++) {
+        if (memcmp(lut->table[c], lut->table[0], 256) != 0) return 0;
+    }
+    return 1;
+}
+
+typedef struct {
+    const t_lut *lut;
+    uint8_t *pixels;
+    int width;
+    size_t stride;
+    int channels;   // 3, or 4 with the alpha byte left as it is
+} t_lut_rows_job;
+
+// Per-channel tables on rows [begin, end) of an RGB or RGBA buffer
+static void lut_rgb_rows(int begin, int end, void *ctx) {
+    const t_lut_rows_job *job = (const t_lut_rows_job *)ctx;
+    int single = job->lut->channels == 1;
+    const uint8_t *r = job->lut->table[0], *g = job->lut->table[single ? 0 : 1], *b = job->lut->table[single ? 0 : 2];
+    for (int y = begin; y < end; y++) {
+        uint8_t *px = job->pixels + (size_t)y * job->stride;
+        for (int x = 0; x < job->width; x++, px += job->channels) {
+            px[0] = r[px[0]];
+            px[1] = g[px[1]];
+            px[2] = b[px[2]];
+        }
+    }
+}
+
+void lut_apply_u8(const t_lut *lut, uint8_t *pixels, int width, int height, size_t stride, int channels) {
+    if (!lut || !pixels || width <= 0 || height <= 0 || lut_is_identity(lut)) return;
+
+    if (channels == 1 || (channels == 3 && (lut->channels == 1 || lut_is_uniform(lut)))) {
+        // Same table everywhere: sweep the whole buffer (row padding included)
+        u8_lut(pixels, stride * height, lut->table[0]);
+        return;
+    }
+    if (channels == 4 && stride == (size_t)width * 4 && (lut->channels == 1 || lut_is_uniform(lut))) {
+        // Same again on unpadded RGBA rows, skipping the alpha bytes
+        rgba_lut(pixels, stride * height, lut->table[0]);
+        return;
+    }
+    t_lut_rows_job job = {lut, pixels, width, stride, channels};
+    if (stride * height < LUT_PARALLEL_MIN) {
+        lut_rgb_rows(0, height, &job);
+    } else {
+        parallel_for(0, height, lut_rgb_rows, &job);
+    }
+}
+
+void bmp8_applyLUT(t_bmp8 *img, const t_lut *lut) {
+    if (!img || !img->data || !lut || bmp8_makeWritable(img) != 0) return;
+    // One sweep over the packed bytes; dataSize does not always fit the int width
+    if (!lut_is_identity(lut)) u8_lut(img->data, img->dataSize, lut->table[0]);
+    printf("8-bit LUT applied.\n");
+}
+
+void bmp24_applyLUT(t_bmp24 *img, const t_lut *lut) {
+    if (!img || !img->data || !lut || bmp24_makeWritable(img) != 0) return;
+    lut_apply_u8(lut, img->pixels, img->info.width, abs(img->info.height), img->stride, 3);
+    printf("24-bit LUT applied.\n");
+}
+
+void bmp32_applyLUT(t_bmp32 *img, const t_lut *lut) {
+    if (!img || !img->data || !lut) return;
+    lut_apply_u8(lut, img->pixels, img->info.width, abs(img->info.height), img->stride, 4);
+    printf("32-bit LUT applied.\n");
+}
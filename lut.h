@@ -0,0 +1,61 @@
+#ifndef LUT_H
+#define LUT_H
+
+#include "bmp8.h"
+#include "bmp24.h"
+#include "bmp32.h"
+
+// Lookup tables for chains of point operations.
+//
+// Negative, brightness, threshold and the equalization remap only depend on
+// the value of each byte, so any sequence of them collapses into one 256-entry
+// table per channel. Build the table with the lut_* calls (each one is applied
+// after the previous ones) and apply it with a single sweep over the image:
+//
+//     t_lut lut;
+//     lut_init(&lut, 3);
+//     lut_brightness(&lut, 30);
+//     lut_negative(&lut);
+//     lut_threshold(&lut, 100);
+//     bmp24_applyLUT(img, &lut);
+//
+// gives the same image as bmp24_brightness, bmp24_negative and a threshold run
+// one after the other.
+
+#define LUT_MAX_CHANNELS 3
+#define LUT_ALL_CHANNELS -1
+
+typedef struct {
+    int channels;                              // 1 for t_bmp8, 3 for t_bmp24 / t_bmp32 (red, green, blue)
+    uint8_t table[LUT_MAX_CHANNELS][256];      // New value of every input value, per channel
+} t_lut;
+
+// Identity table for `channels` channels (clamped to 1..LUT_MAX_CHANNELS)
+void lut_init(t_lut *lut, int channels);
+
+// Same mappings as bmp8_negative / bmp8_brightness / bmp8_threshold, on every channel
+void lut_negative(t_lut *lut);
+void lut_brightness(t_lut *lut, int value);
+void lut_threshold(t_lut *lut, int threshold);
+
+// Arbitrary mapping (values above 255 are clamped), e.g. the equalization map of
+// bmp8_computeAndNormalizeCDF. channel is 0..channels-1 or LUT_ALL_CHANNELS.
+void lut_remap(t_lut *lut, int channel, const unsigned int *map);
+
+// Appends `next` after `lut`: the result maps v to next(lut(v)), channel by channel
+void lut_then(t_lut *lut, const t_lut *next);
+
+// Returns 1 if the table leaves every value unchanged
+int lut_is_identity(const t_lut *lut);
+
+// Applies the table to a raw interleaved buffer (channels 1, 3 or 4 as in
+// convolution.h; the alpha byte of 4-channel pixels is left as it is)
+void lut_apply_u8(const t_lut *lut, uint8_t *pixels, int width, int height, size_t stride, int channels);
+
+// Apply the table in one pass over the pixels (a 1-channel table is used for all
+// three color channels of a 24-bit or 32-bit image)
+void bmp8_applyLUT(t_bmp8 *img, const t_lut *lut);
+void bmp24_applyLUT(t_bmp24 *img, const t_lut *lut);
+void bmp32_applyLUT(t_bmp32 *img, const t_lut *lut);
+
+#endif // LUT_H
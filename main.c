@@ -1,9 +1,15 @@
+#include <errno.h>
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "bmp8.h"
 #include "bmp24.h"
+#include "bmp32.h"
 #include "histogram.h"
 #include "utils.h"
+#include "convolution.h"
+#include "pipeline.h"
 
 void display_main_menu() {
     printf("\n===== Image Processing Menu =====\n");
@@ -27,6 +33,7 @@ void display_part1_menu() {
     printf("9. Apply Emboss Filter\n");
     printf("10. Apply Sharpen Filter\n");
     printf("11. Apply Histogram Equalization (Part 3)\n");
+    printf("12. Apply Adaptive Equalization (CLAHE)\n");
     printf("0. Back to Main Menu\n");
     printf("----------------------------------\n");
     printf(">>> Your choice: ");
@@ -45,6 +52,7 @@ void display_part2_menu() {
     printf("9. Apply Emboss Filter\n");
     printf("10. Apply Sharpen Filter\n");
     printf("11. Apply Histogram Equalization (Part 3)\n");
+    printf("12. Apply Adaptive Equalization (CLAHE)\n");
     printf("0. Back to Main Menu\n");
     printf("----------------------------------\n");
     printf(">>> Your choice: ");
@@ -99,6 +107,7 @@ void handle_part1(t_bmp8 *img8) {
             case 9: bmp8_emboss(img8); break;
             case 10: bmp8_sharpen(img8); break;
             case 11: bmp8_equalize(img8); break;
+            case 12: bmp8_clahe(img8, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_CLIP_LIMIT); break;
             case 0:
                 printf("Returning to main menu...\n");
                 break;
@@ -154,6 +163,7 @@ void handle_part2(t_bmp24 *img24) {
             case 9: bmp24_emboss(img24); break;
             case 10: bmp24_sharpen(img24); break;
             case 11: bmp24_equalize(img24); break;
+            case 12: bmp24_clahe(img24, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_CLIP_LIMIT); break;
             case 0:
                 printf("Returning to main menu...\n");
                 break;
@@ -164,7 +174,284 @@ void handle_part2(t_bmp24 *img24) {
 }
 
 
-int main() {
+// --- Batch mode (non-interactive command line) ---
+
+typedef enum {
+    OP_NEGATIVE, OP_GRAYSCALE, OP_BRIGHTNESS, OP_THRESHOLD,
+    OP_BOX_BLUR, OP_BOX_RADIUS, OP_GAUSSIAN_BLUR, OP_OUTLINE, OP_EMBOSS, OP_SHARPEN,
+    OP_EQUALIZE, OP_CLAHE
+} t_operation_kind;
+
+typedef struct {
+    t_operation_kind kind;
+    int value; // Brightness delta, threshold or radius
+} t_operation;
+
+typedef struct {
+    const char *name;       // Command-line flag
+    t_operation_kind kind;
+    int has_value;          // Whether the flag takes an integer argument
+    long min, max;          // Accepted range of the argument
+} t_operation_flag;
+
+static const t_operation_flag operation_flags[] = {
+    {"--negative", OP_NEGATIVE, 0, 0, 0},
+    {"--grayscale", OP_GRAYSCALE, 0, 0, 0},
+    {"--brightness", OP_BRIGHTNESS, 1, INT_MIN, INT_MAX},
+    {"--threshold", OP_THRESHOLD, 1, INT_MIN, INT_MAX},
+    {"--box", OP_BOX_BLUR, 0, 0, 0},
+    {"--box-radius", OP_BOX_RADIUS, 1, 1, BOX_MAX_RADIUS},
+    {"--gaussian", OP_GAUSSIAN_BLUR, 0, 0, 0},
+    {"--outline", OP_OUTLINE, 0, 0, 0},
+    {"--emboss", OP_EMBOSS, 0, 0, 0},
+    {"--sharpen", OP_SHARPEN, 0, 0, 0},
+    {"--equalize", OP_EQUALIZE, 0, 0, 0},
+    {"--clahe", OP_CLAHE, 0, 0, 0},
+};
+#define NUM_OPERATION_FLAGS (sizeof(operation_flags) / sizeof(operation_flags[0]))
+
+void print_usage(const char *program) {
+    printf("Usage:\n");
+    printf("  %s                                  interactive menus\n", program);
+    printf("  %s [options] <operations> <input.bmp>...\n\n", program);
+    printf("Each input is loaded once, the operations are applied in order, and the\n");
+    printf("result is saved once. 8-bit, 24-bit and 32-bit files are detected automatically.\n");
+    printf("Point operations are merged into one pass and filters run strip by strip.\n\n");
+    printf("Operations:\n");
+    printf("  --negative  --grayscale (color)  --brightness N  --threshold N\n");
+    printf("  --box  --box-radius R  --gaussian  --outline  --emboss  --sharpen  --equalize  --clahe\n\n");
+    printf("Options:\n");
+    printf("  -o, --output-dir DIR   write results to DIR (default: next to each input)\n");
+    printf("  --suffix TEXT          appended to output file names (default: _out)\n");
+    printf("  --threads N            worker threads for the filters (default: all CPUs)\n");
+    printf("  --fixed                fixed-point convolution instead of float\n");
+    printf("  --stream               process rows from disk without loading the image\n");
+    printf("                         (8-bit and 24-bit files; bounded memory; no --equalize / --clahe)\n");
+    printf("  --tile N               filter column tile in pixels (0: automatic, -1: whole rows)\n");
+    printf("  -q, --quiet            only report errors\n");
+    printf("  -h, --help             show this help\n");
+}
+
+// Reads the bits-per-pixel field of a BMP file, 0 on error
+int read_bmp_depth(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    uint8_t header[BITMAP_DEPTH + 2];
+    size_t got = fread(header, 1, sizeof(header), file);
+    fclose(file);
+    if (got != sizeof(header) || header[0] != 'B' || header[1] != 'M') return 0;
+    return header[BITMAP_DEPTH] | (header[BITMAP_DEPTH + 1] << 8);
+}
+
+// Output path: <dir>/<name><suffix>.bmp, or next to the input when dir is NULL.
+// Returns 0 on success, 1 if the path does not fit in `size` bytes.
+int build_output_path(char *out, size_t size, const char *input, const char *dir, const char *suffix) {
+    const char *base = strrchr(input, '/');
+    base = base ? base + 1 : input;
+    const char *ext = strrchr(base, '.');
+    int name_len = ext ? (int)(ext - base) : (int)strlen(base);
+
+    int len;
+    if (dir) {
+        len = snprintf(out, size, "%s/%.*s%s%s", dir, name_len, base, suffix, ext ? ext : ".bmp");
+    } else {
+        len = snprintf(out, size, "%.*s%.*s%s%s", (int)(base - input), input, name_len, base, suffix, ext ? ext : ".bmp");
+    }
+    return (len < 0 || (size_t)len >= size) ? 1 : 0;
+}
+
+// Parses a whole decimal integer in [min, max]; returns 0 on success
+int parse_int(const char *text, long min, long max, int *value) {
+    char *end = NULL;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < min || parsed > max) return -1;
+    *value = (int)parsed;
+    return 0;
+}
+
+// Adds one command line operation to the image's pipeline
+int record_operation(t_pipeline *pipe, const t_operation *op) {
+    switch (op->kind) {
+        case OP_NEGATIVE: return pipeline_negative(pipe);
+        case OP_GRAYSCALE: return pipeline_grayscale(pipe);
+        case OP_BRIGHTNESS: return pipeline_brightness(pipe, op->value);
+        case OP_THRESHOLD: return pipeline_threshold(pipe, op->value);
+        case OP_BOX_BLUR: return pipeline_boxBlur(pipe);
+        case OP_BOX_RADIUS: return pipeline_boxBlurRadius(pipe, op->value);
+        case OP_GAUSSIAN_BLUR: return pipeline_gaussianBlur(pipe);
+        case OP_OUTLINE: return pipeline_outline(pipe);
+        case OP_EMBOSS: return pipeline_emboss(pipe);
+        case OP_SHARPEN: return pipeline_sharpen(pipe);
+        case OP_EQUALIZE: return pipeline_equalize(pipe);
+        case OP_CLAHE: return pipeline_clahe(pipe, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_CLIP_LIMIT);
+    }
+    return 1;
+}
+
+// Loads the file, runs the operations as one pipeline (point operations fused,
+// convolutions streamed in strips) and saves the result. With `stream`, the
+// image is never loaded: rows go from input to output through pipeline_stream.
+int process_file(const char *input, const char *output, const t_operation *ops, int num_ops, int stream) {
+    int depth = read_bmp_depth(input);
+    t_bmp8 *img8 = NULL;
+    t_bmp24 *img24 = NULL;
+    t_bmp32 *img32 = NULL;
+    t_pipeline *pipe = NULL;
+
+    if (stream) {
+        pipe = pipeline_createStream();
+    } else if (depth == DEFAULT_DEPTH_8BIT) {
+        img8 = bmp8_loadImage(input);
+        if (!img8) return 1;
+        pipe = pipeline_create8(img8);
+    } else if (depth == DEFAULT_DEPTH_24BIT) {
+        img24 = bmp24_loadImage(input);
+        if (!img24) return 1;
+        pipe = pipeline_create24(img24);
+    } else if (depth == 32) {
+        img32 = bmp32_loadImage(input);
+        if (!img32) return 1;
+        pipe = pipeline_create32(img32);
+    } else {
+        fprintf(stderr, "%s: not an 8-bit, 24-bit or 32-bit BMP file.\n", input);
+        return 1;
+    }
+
+    int status = pipe ? 0 : 1;
+    for (int i = 0; i < num_ops && status == 0; i++) {
+        status = record_operation(pipe, &ops[i]);
+    }
+    if (status == 0) status = stream ? pipeline_stream(pipe, input, output) : pipeline_save(pipe, output);
+
+    pipeline_free(pipe);
+    if (img8) bmp8_free(img8);
+    if (img24) bmp24_free(img24);
+    if (img32) bmp32_free(img32);
+    return status;
+}
+
+int run_batch(int argc, char *argv[]) {
+    t_operation *ops = (t_operation *)malloc(argc * sizeof(t_operation));
+    const char **inputs = (const char **)malloc(argc * sizeof(const char *));
+    if (!ops || !inputs) {
+        perror("Error allocating command line");
+        free(ops);
+        free(inputs);
+        return 1;
+    }
+    int num_ops = 0, num_inputs = 0;
+    const char *output_dir = NULL;
+    const char *suffix = "_out";
+    int quiet = 0;
+    int stream = 0;
+    int status = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const t_operation_flag *flag = NULL;
+        for (size_t f = 0; f < NUM_OPERATION_FLAGS; f++) {
+            if (strcmp(arg, operation_flags[f].name) == 0) flag = &operation_flags[f];
+        }
+
+        if (flag) {
+            ops[num_ops].kind = flag->kind;
+            ops[num_ops].value = 0;
+            if (flag->has_value) {
+                if (i + 1 >= argc || parse_int(argv[i + 1], flag->min, flag->max, &ops[num_ops].value) != 0) {
+                    fprintf(stderr, "%s expects an integer argument between %ld and %ld.\n", arg, flag->min, flag->max);
+                    status = 2;
+                    goto done;
+                }
+                i++;
+            }
+            num_ops++;
+        } else if ((strcmp(arg, "-o") == 0 || strcmp(arg, "--output-dir") == 0) && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (strcmp(arg, "--suffix") == 0 && i + 1 < argc) {
+            suffix = argv[++i];
+        } else if (strcmp(arg, "--threads") == 0) {
+            int threads;
+            if (i + 1 >= argc || parse_int(argv[i + 1], 0, INT_MAX, &threads) != 0) {
+                fprintf(stderr, "--threads expects a thread count (0 for all CPUs).\n\n");
+                print_usage(argv[0]);
+                status = 2;
+                goto done;
+            }
+            set_num_threads(threads);
+            i++;
+        } else if (strcmp(arg, "--tile") == 0) {
+            int tile;
+            if (i + 1 >= argc || parse_int(argv[i + 1], -1, INT_MAX, &tile) != 0) {
+                fprintf(stderr, "--tile expects a width in pixels (0: automatic, -1: whole rows).\n\n");
+                print_usage(argv[0]);
+                status = 2;
+                goto done;
+            }
+            set_convolution_tile_width(tile);
+            i++;
+        } else if (strcmp(arg, "--stream") == 0) {
+            stream = 1;
+        } else if (strcmp(arg, "--fixed") == 0) {
+            set_convolution_precision(CONV_PRECISION_FIXED);
+        } else if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quiet") == 0) {
+            quiet = 1;
+        } else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            goto done;
+        } else if (arg[0] == '-') {
+            fprintf(stderr, "Unknown option %s (see --help).\n", arg);
+            status = 2;
+            goto done;
+        } else {
+            inputs[num_inputs++] = arg;
+        }
+    }
+
+    if (num_inputs == 0) {
+        fprintf(stderr, "No input files (see --help).\n");
+        status = 2;
+        goto done;
+    }
+
+    // The filters report every step on stdout
+    if (quiet && !freopen("/dev/null", "w", stdout)) {
+        perror("Error silencing output");
+    }
+
+    int failures = 0;
+    char output[1024];
+    for (int i = 0; i < num_inputs; i++) {
+        if (build_output_path(output, sizeof(output), inputs[i], output_dir, suffix) != 0) {
+            fprintf(stderr, "%s: output path longer than %zu characters.\n", inputs[i], sizeof(output) - 1);
+            failures++;
+            continue;
+        }
+        // Streaming would truncate the file it is reading, and loading would replace
+        // the only copy of the input: both are refused
+        if (strcmp(output, inputs[i]) == 0 || file_isSame(output, inputs[i])) {
+            fprintf(stderr, "%s: the output would overwrite the input (use -o or a non-empty --suffix).\n", inputs[i]);
+            failures++;
+            continue;
+        }
+        if (process_file(inputs[i], output, ops, num_ops, stream) != 0) {
+            fprintf(stderr, "Failed to process %s\n", inputs[i]);
+            failures++;
+        }
+    }
+    if (failures > 0) {
+        fprintf(stderr, "%d of %d files failed.\n", failures, num_inputs);
+        status = 1;
+    }
+
+done:
+    free(ops);
+    free(inputs);
+    return status;
+}
+
+
+int main(int argc, char *argv[]) {
     int choice;
     char filename[256];
     t_bmp8 *current_img8 = NULL;
@@ -172,6 +459,13 @@ int main() {
 
     initialize_kernels(); // Initialize global filter kernels
 
+    // Any argument switches to batch mode: kernels are set up once for all the files
+    if (argc > 1) {
+        int status = run_batch(argc, argv);
+        cleanup_kernels();
+        return status;
+    }
+
     do {
         // Free any previously loaded image if we are at the main menu
         if (current_img8) { bmp8_free(current_img8); current_img8 = NULL; }
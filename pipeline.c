@@ -0,0 +1,693 @@
+#include "pipeline.h"
+#include "convolution.h"
+#include "histogram.h"
+#include "pixelops.h"
+
+// Target size of a strip of image rows, so that the strip buffers stay in cache
+#ifndef PIPELINE_STRIP_BYTES
+#define PIPELINE_STRIP_BYTES (512u << 10)
+#endif
+
+// Strip passes over images below this size run on the calling thread
+#define PIPELINE_PARALLEL_MIN (1u << 20)
+
+// Chains of up to this many point operations run one after the other on the
+// vector kernels of pixelops.c, longer ones through their folded lookup table.
+// On a strip in cache each vector pass costs about 1/13 of a table sweep
+// (16 MP, 24-bit, SSE2/AVX2); the scalar kernels are table lookups themselves.
+#ifndef PIPELINE_POINT_KERNELS_MAX
+#define PIPELINE_POINT_KERNELS_MAX 8
+#endif
+
+// --- Recording ---
+
+static t_pipeline *pipeline_create(t_bmp8 *img8, t_bmp24 *img24, t_bmp32 *img32) {
+    t_pipeline *pipe = (t_pipeline *)calloc(1, sizeof(t_pipeline));
+    if (!pipe) {
+        perror("Error allocating pipeline");
+        return NULL;
+    }
+    pipe->img8 = img8;
+    pipe->img24 = img24;
+    pipe->img32 = img32;
+    return pipe;
+}
+
+t_pipeline *pipeline_create8(t_bmp8 *img) {
+    if (!img || !img->data) return NULL;
+    return pipeline_create(img, NULL, NULL);
+}
+
+t_pipeline *pipeline_create24(t_bmp24 *img) {
+    if (!img || !img->data) return NULL;
+    return pipeline_create(NULL, img, NULL);
+}
+
+t_pipeline *pipeline_create32(t_bmp32 *img) {
+    if (!img || !img->data) return NULL;
+    return pipeline_create(NULL, NULL, img);
+}
+
+t_pipeline *pipeline_createStream(void) {
+    return pipeline_create(NULL, NULL, NULL);
+}
+
+void pipeline_free(t_pipeline *pipe) {
+    if (!pipe) return;
+    free(pipe->ops);
+    free(pipe);
+}
+
+static int pipeline_push(t_pipeline *pipe, t_pipeline_op op) {
+    if (!pipe) return 1;
+    if (pipe->numOps == pipe->capacity) {
+        int capacity = pipe->capacity ? pipe->capacity * 2 : 8;
+        t_pipeline_op *ops = (t_pipeline_op *)realloc(pipe->ops, capacity * sizeof(t_pipeline_op));
+        if (!ops) {
+            perror("Error growing pipeline");
+            return 1;
+        }
+        pipe->ops = ops;
+        pipe->capacity = capacity;
+    }
+    pipe->ops[pipe->numOps++] = op;
+    return 0;
+}
+
+static int pipeline_push_kind(t_pipeline *pipe, t_pipeline_op_kind kind, int value) {
+    t_pipeline_op op = {kind, value, 0.0f, NULL, 0};
+    return pipeline_push(pipe, op);
+}
+
+int pipeline_negative(t_pipeline *pipe) { return pipeline_push_kind(pipe, PIPE_NEGATIVE, 0); }
+int pipeline_brightness(t_pipeline *pipe, int value) { return pipeline_push_kind(pipe, PIPE_BRIGHTNESS, value); }
+int pipeline_threshold(t_pipeline *pipe, int threshold) { return pipeline_push_kind(pipe, PIPE_THRESHOLD, threshold); }
+int pipeline_grayscale(t_pipeline *pipe) { return pipeline_push_kind(pipe, PIPE_GRAYSCALE, 0); }
+int pipeline_equalize(t_pipeline *pipe) { return pipeline_push_kind(pipe, PIPE_EQUALIZE, 0); }
+
+int pipeline_filter(t_pipeline *pipe, float **kernel, int kernelSize) {
+    if (!kernel || kernelSize <= 0 || kernelSize % 2 == 0) {
+        fprintf(stderr, "Error: Invalid kernel for pipeline_filter.\n");
+        return 1;
+    }
+    t_pipeline_op op = {PIPE_FILTER, 0, 0.0f, kernel, kernelSize};
+    return pipeline_push(pipe, op);
+}
+
+int pipeline_boxBlur(t_pipeline *pipe) { return pipeline_filter(pipe, BOX_BLUR_KERNEL, KERNEL_SIZE_3x3); }
+int pipeline_gaussianBlur(t_pipeline *pipe) { return pipeline_filter(pipe, GAUSSIAN_BLUR_KERNEL, KERNEL_SIZE_3x3); }
+int pipeline_outline(t_pipeline *pipe) { return pipeline_filter(pipe, OUTLINE_KERNEL, KERNEL_SIZE_3x3); }
+int pipeline_emboss(t_pipeline *pipe) { return pipeline_filter(pipe, EMBOSS_KERNEL, KERNEL_SIZE_3x3); }
+int pipeline_sharpen(t_pipeline *pipe) { return pipeline_filter(pipe, SHARPEN_KERNEL, KERNEL_SIZE_3x3); }
+
+int pipeline_boxBlurRadius(t_pipeline *pipe, int radius) {
+    if (radius <= 0 || radius > BOX_MAX_RADIUS) {
+        fprintf(stderr, "Error: Invalid radius for pipeline_boxBlurRadius.\n");
+        return 1;
+    }
+    return pipeline_push_kind(pipe, PIPE_BOX_RADIUS, radius);
+}
+
+int pipeline_clahe(t_pipeline *pipe, int tiles, float clipLimit) {
+    t_pipeline_op op = {PIPE_CLAHE, tiles, clipLimit, NULL, 0};
+    return pipeline_push(pipe, op);
+}
+
+// --- Execution ---
+
+// Image as a raw interleaved buffer, like the convolution engine sees it
+typedef struct {
+    uint8_t *pixels;
+    int width, height;
+    size_t stride;
+    int channels;
+} t_image_view;
+
+typedef enum { STAGE_POINT, STAGE_GRAYSCALE, STAGE_CONVOLVE, STAGE_BOX } t_stage_kind;
+
+// One step of a strip pass
+typedef struct {
+    t_stage_kind kind;
+    const t_pipeline_op *ops; // STAGE_POINT: the adjacent point operations, in order
+    int numOps;
+    t_lut lut;          // STAGE_POINT: the same operations folded together
+    float **kernel;     // STAGE_CONVOLVE
+    int kernelSize;
+    int radius;         // Rows of context needed above and below (0 for point stages)
+} t_stage;
+
+static int is_barrier(t_pipeline_op_kind kind) {
+    return kind == PIPE_EQUALIZE || kind == PIPE_CLAHE;
+}
+
+// Runs a chain of point operations on whole rows (padding included, like
+// lut_apply_u8). The RGBA kernels mask the alpha byte of every 4-byte group,
+// so they need rows without padding.
+static void stage_point_rows(const t_stage *stage, const t_image_view *view, uint8_t *rows, int count) {
+    int rgba = view->channels == 4;
+    int max_ops = (strcmp(u8_simd_level(), "scalar") == 0) ? 1 : PIPELINE_POINT_KERNELS_MAX;
+    if (stage->numOps > max_ops || (rgba && view->stride != (size_t)view->width * 4)) {
+        lut_apply_u8(&stage->lut, rows, view->width, count, view->stride, view->channels);
+        return;
+    }
+    size_t n = (size_t)count * view->stride;
+    for (int i = 0; i < stage->numOps; i++) {
+        const t_pipeline_op *op = &stage->ops[i];
+        if (op->kind == PIPE_NEGATIVE) {
+            if (rgba) rgba_negative(rows, n);
+            else u8_negative(rows, n);
+        } else if (op->kind == PIPE_BRIGHTNESS) {
+            if (rgba) rgba_brightness(rows, n, op->value);
+            else u8_brightness(rows, n, op->value);
+        } else {
+            if (rgba) rgba_threshold(rows, n, op->value);
+            else u8_threshold(rows, n, op->value);
+        }
+    }
+}
+
+// Point stages work on rows in place
+static void stage_rows_in_place(const t_stage *stage, const t_image_view *view, uint8_t *rows, int count) {
+    if (stage->kind == STAGE_POINT) {
+        stage_point_rows(stage, view, rows, count);
+    } else if (view->channels == 4) {
+        for (int y = 0; y < count; y++) bmp32_grayscaleRow((t_rgba_pixel *)(rows + (size_t)y * view->stride), view->width);
+    } else {
+        for (int y = 0; y < count; y++) bmp24_grayscaleRow((t_rgb_pixel *)(rows + (size_t)y * view->stride), view->width);
+    }
+}
+
+// Rows per strip: about PIPELINE_STRIP_BYTES, and at least the total halo so that
+// the rows a strip needs above it all come from the previous strip
+static int strip_rows_for(size_t stride, int halo) {
+    int strip_rows = (int)(PIPELINE_STRIP_BYTES / stride);
+    if (strip_rows < halo) strip_rows = halo;
+    return (strip_rows < 1) ? 1 : strip_rows;
+}
+
+static int stages_halo(const t_stage *stages, int numStages) {
+    int halo = 0;
+    for (int s = 0; s < numStages; s++) halo += stages[s].radius;
+    return halo;
+}
+
+// Runs the stages on the input rows [lo, hi) held at the start of buffers[0].
+//
+// A strip of output rows [y0, y1) needs the input rows [y0 - halo, y1 + halo),
+// halo being the sum of the kernel radii. Each convolution stage narrows the
+// range of valid rows by its radius, except at the top and bottom of the image
+// where the border rows are left untouched like the filters do. Returns the
+// buffer holding the result, rows still counted from the original lo.
+static uint8_t *strip_apply(const t_image_view *view, const t_stage *stages, int numStages,
+                            uint8_t *buffers[2], int lo, int hi) {
+    size_t stride = view->stride;
+    int base = lo;
+    uint8_t *cur = buffers[0], *next = buffers[1];
+
+    for (int s = 0; s < numStages; s++) {
+        const t_stage *stage = &stages[s];
+        uint8_t *src = cur + (size_t)(lo - base) * stride;
+        if (stage->radius == 0) {
+            stage_rows_in_place(stage, view, src, hi - lo);
+            continue;
+        }
+        uint8_t *dst = next + (size_t)(lo - base) * stride;
+        // Border rows and columns are kept as they are
+        memcpy(dst, src, (size_t)(hi - lo) * stride);
+        if (stage->kind == STAGE_BOX) {
+            convolve_box_u8(src, dst, view->width, hi - lo, stride, view->channels, stage->radius);
+        } else {
+            convolve_u8(src, dst, view->width, hi - lo, stride, view->channels, stage->kernel, stage->kernelSize);
+        }
+        lo = (lo == 0) ? 0 : lo + stage->radius;
+        hi = (hi == view->height) ? view->height : hi - stage->radius;
+        uint8_t *swap = cur;
+        cur = next;
+        next = swap;
+    }
+    return cur;
+}
+
+typedef struct {
+    const t_image_view *view;
+    const t_stage *stages;
+    int numStages;
+    int halo;
+    int strip_rows;
+    int num_strips;
+    int num_bands;
+    uint8_t *edges;     // Original rows [Y - halo, Y + halo) around each band boundary Y
+} t_strip_job;
+
+// First row of `band`: bands are runs of whole strips
+static int strip_band_start(const t_strip_job *job, int band) {
+    int y = (int)((long long)job->num_strips * band / job->num_bands) * job->strip_rows;
+    return (y < job->view->height) ? y : job->view->height;
+}
+
+// Runs the strips of bands [band_begin, band_end) one after the other. Output is
+// written back into the image, so the original rows the next strip needs above
+// it are saved first; rows that belong to the neighbouring bands come from the
+// edges saved before the bands started.
+static void strip_bands(int band_begin, int band_end, void *arg) {
+    const t_strip_job *job = (const t_strip_job *)arg;
+    const t_image_view *view = job->view;
+    size_t stride = view->stride;
+    int height = view->height;
+    int halo = job->halo;
+
+    if (halo == 0) {
+        int top = strip_band_start(job, band_begin);
+        int bottom = strip_band_start(job, band_end);
+        for (int y0 = top; y0 < bottom; y0 += job->strip_rows) {
+            int count = (y0 + job->strip_rows < bottom) ? job->strip_rows : bottom - y0;
+            for (int s = 0; s < job->numStages; s++) {
+                stage_rows_in_place(&job->stages[s], view, view->pixels + (size_t)y0 * stride, count);
+            }
+        }
+        return;
+    }
+
+    size_t buffer_size = (size_t)(job->strip_rows + 2 * halo) * stride;
+    size_t edge_size = 2 * (size_t)halo * stride;
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    uint8_t *buffers[2] = {(uint8_t *)arena_alloc(arena, buffer_size), (uint8_t *)arena_alloc(arena, buffer_size)};
+    uint8_t *saved = (uint8_t *)arena_alloc(arena, (size_t)halo * stride);
+    if (!buffers[0] || !buffers[1] || !saved) {
+        perror("Error allocating pipeline strips");
+        arena_release(arena, mark);
+        return;
+    }
+
+    for (int band = band_begin; band < band_end; band++) {
+        int top = strip_band_start(job, band);
+        int bottom = strip_band_start(job, band + 1);
+        const uint8_t *above = (band > 0) ? job->edges + (band - 1) * edge_size : saved;
+        for (int y0 = top; y0 < bottom; y0 += job->strip_rows) {
+            int y1 = (y0 + job->strip_rows < bottom) ? y0 + job->strip_rows : bottom;
+            int lo = (y0 > halo) ? y0 - halo : 0;
+            int hi = (y1 + halo < height) ? y1 + halo : height;
+            int own = (hi < bottom) ? hi : bottom;
+
+            // Rows above y0 were already overwritten in the image, by this band
+            // or by the one above
+            const uint8_t *prev = (y0 == top) ? above : saved;
+            memcpy(buffers[0], prev + (size_t)(halo - (y0 - lo)) * stride, (size_t)(y0 - lo) * stride);
+            memcpy(buffers[0] + (size_t)(y0 - lo) * stride, view->pixels + (size_t)y0 * stride, (size_t)(own - y0) * stride);
+            if (hi > own) {
+                memcpy(buffers[0] + (size_t)(own - lo) * stride, job->edges + band * edge_size + (size_t)halo * stride,
+                       (size_t)(hi - own) * stride);
+            }
+
+            uint8_t *result = strip_apply(view, job->stages, job->numStages, buffers, lo, hi);
+
+            int keep = (y1 < halo) ? y1 : halo;
+            memcpy(saved + (size_t)(halo - keep) * stride, view->pixels + (size_t)(y1 - keep) * stride, (size_t)keep * stride);
+            memcpy(view->pixels + (size_t)y0 * stride, result + (size_t)(y0 - lo) * stride, (size_t)(y1 - y0) * stride);
+        }
+    }
+    arena_release(arena, mark);
+}
+
+// Runs every stage over the image, one horizontal strip at a time. On large
+// images the strips are split into one band per thread.
+static int run_stages(const t_image_view *view, const t_stage *stages, int numStages) {
+    size_t stride = view->stride;
+    int height = view->height;
+    t_strip_job job = {view, stages, numStages, stages_halo(stages, numStages), 0, 0, 1, NULL};
+    job.strip_rows = strip_rows_for(stride, job.halo);
+    job.num_strips = (height + job.strip_rows - 1) / job.strip_rows;
+    if (stride * height >= PIPELINE_PARALLEL_MIN) {
+        job.num_bands = (get_num_threads() < job.num_strips) ? get_num_threads() : job.num_strips;
+    }
+
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    if (job.num_bands > 1 && job.halo > 0) {
+        size_t edge_size = 2 * (size_t)job.halo * stride;
+        job.edges = (uint8_t *)arena_alloc(arena, (job.num_bands - 1) * edge_size);
+        if (!job.edges) {
+            perror("Error allocating pipeline band edges");
+            arena_release(arena, mark);
+            return 1;
+        }
+        for (int b = 1; b < job.num_bands; b++) {
+            // The last band can be shorter than the halo
+            int first = strip_band_start(&job, b) - job.halo;
+            int rows = (first + 2 * job.halo < height) ? 2 * job.halo : height - first;
+            memcpy(job.edges + (b - 1) * edge_size, view->pixels + (size_t)first * stride, (size_t)rows * stride);
+        }
+    }
+    parallel_for(0, job.num_bands, strip_bands, &job);
+    arena_release(arena, mark);
+    return 0;
+}
+
+// Turns the operations ops[0..count) (no barrier among them) into stages.
+// Returns the number of stages written to `stages` (at most count).
+static int build_stages(const t_pipeline_op *ops, int count, int channels, t_stage *stages) {
+    int numStages = 0;
+    for (int i = 0; i < count; i++) {
+        const t_pipeline_op *op = &ops[i];
+        t_stage *stage = &stages[numStages];
+        int point = op->kind == PIPE_NEGATIVE || op->kind == PIPE_BRIGHTNESS || op->kind == PIPE_THRESHOLD;
+
+        if (point) {
+            // Extend the previous point stage if this operation directly follows
+            // its last one (a grayscale skipped on 8-bit images sits in between)
+            const t_stage *last = numStages ? &stages[numStages - 1] : NULL;
+            if (!last || last->kind != STAGE_POINT || last->ops + last->numOps != op) {
+                stage->kind = STAGE_POINT;
+                stage->ops = op;
+                stage->numOps = 0;
+                stage->radius = 0;
+                lut_init(&stage->lut, channels);
+                numStages++;
+            }
+            stages[numStages - 1].numOps++;
+            t_lut *lut = &stages[numStages - 1].lut;
+            if (op->kind == PIPE_NEGATIVE) lut_negative(lut);
+            else if (op->kind == PIPE_BRIGHTNESS) lut_brightness(lut, op->value);
+            else lut_threshold(lut, op->value);
+        } else if (op->kind == PIPE_GRAYSCALE) {
+            if (channels == 1) continue;
+            stage->kind = STAGE_GRAYSCALE;
+            stage->radius = 0;
+            numStages++;
+        } else if (op->kind == PIPE_FILTER) {
+            stage->kind = STAGE_CONVOLVE;
+            stage->kernel = op->kernel;
+            stage->kernelSize = op->kernelSize;
+            stage->radius = op->kernelSize / 2;
+            numStages++;
+        } else {
+            stage->kind = STAGE_BOX;
+            stage->radius = op->value;
+            numStages++;
+        }
+    }
+    return numStages;
+}
+
+// The box blur leaves an image untouched when its window does not fit: the
+// pipeline reports it instead of skipping the operation
+static int check_box_radii(const t_pipeline *pipe, int width, int height) {
+    for (int i = 0; i < pipe->numOps; i++) {
+        int radius = pipe->ops[i].value;
+        if (pipe->ops[i].kind == PIPE_BOX_RADIUS && (width <= 2 * radius || height <= 2 * radius)) {
+            fprintf(stderr, "Error: Box blur radius %d does not fit a %dx%d image.\n", radius, width, height);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Equalization steps, run on the whole image
+static void run_barrier(t_pipeline *pipe, const t_pipeline_op *op) {
+    if (op->kind == PIPE_EQUALIZE) {
+        if (pipe->img8) bmp8_equalize(pipe->img8);
+        else if (pipe->img32) bmp32_equalize(pipe->img32);
+        else bmp24_equalize(pipe->img24);
+    } else {
+        if (pipe->img8) bmp8_clahe(pipe->img8, op->value, op->value, op->clipLimit);
+        else if (pipe->img32) bmp32_clahe(pipe->img32, op->value, op->value, op->clipLimit);
+        else bmp24_clahe(pipe->img24, op->value, op->value, op->clipLimit);
+    }
+}
+
+int pipeline_materialize(t_pipeline *pipe) {
+    if (!pipe) return 1;
+    if (pipe->numOps == 0) return 0;
+    if (!pipe->img8 && !pipe->img24 && !pipe->img32) {
+        fprintf(stderr, "Error: This pipeline has no image, run it with pipeline_stream.\n");
+        return 1;
+    }
+
+    // Mapped images are converted from their file layout before the strips start
+    if ((pipe->img8 && bmp8_makeWritable(pipe->img8) != 0) || (pipe->img24 && bmp24_makeWritable(pipe->img24) != 0)) {
+        return 1;
+    }
+
+    t_image_view view;
+    if (pipe->img8) {
+        t_image_view v8 = {pipe->img8->data, (int)pipe->img8->width, (int)pipe->img8->height, pipe->img8->width, 1};
+        view = v8;
+    } else if (pipe->img32) {
+        t_image_view v32 = {pipe->img32->pixels, pipe->img32->info.width, abs(pipe->img32->info.height), pipe->img32->stride, 4};
+        view = v32;
+    } else {
+        t_image_view v24 = {pipe->img24->pixels, pipe->img24->info.width, abs(pipe->img24->info.height), pipe->img24->stride, 3};
+        view = v24;
+    }
+    if (check_box_radii(pipe, view.width, view.height) != 0) return 1;
+
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    t_stage *stages = (t_stage *)arena_alloc(arena, pipe->numOps * sizeof(t_stage));
+    if (!stages) {
+        perror("Error allocating pipeline stages");
+        return 1;
+    }
+
+    int status = 0, passes = 0;
+    for (int i = 0; i < pipe->numOps && status == 0;) {
+        if (is_barrier(pipe->ops[i].kind)) {
+            run_barrier(pipe, &pipe->ops[i++]);
+            passes++;
+            continue;
+        }
+
+        // Everything up to the next barrier goes through one strip pass
+        int end = i;
+        while (end < pipe->numOps && !is_barrier(pipe->ops[end].kind)) end++;
+        int numStages = build_stages(pipe->ops + i, end - i, view.channels, stages);
+        i = end;
+        if (numStages > 0) {
+            status = run_stages(&view, stages, numStages);
+            passes++;
+        }
+    }
+    arena_release(arena, mark);
+
+    if (status == 0) {
+        printf("Pipeline applied: %d operation(s) in %d pass(es).\n", pipe->numOps, passes);
+    }
+    pipe->numOps = 0;
+    return status;
+}
+
+int pipeline_save(t_pipeline *pipe, const char *filename) {
+    if (!pipe || pipeline_materialize(pipe) != 0) return 1;
+    if (pipe->img8) bmp8_saveImage(filename, pipe->img8);
+    else if (pipe->img32) bmp32_saveImage(filename, pipe->img32);
+    else bmp24_saveImage(filename, pipe->img24);
+    return 0;
+}
+
+// --- Streaming ---
+
+// Reads `count` rows of the pixel array. The padding of the very last row may be
+// missing, some writers drop it.
+static int stream_read_rows(FILE *in, uint8_t *dst, int count, int last, const t_image_view *view) {
+    size_t bytes = (size_t)count * view->stride;
+    size_t got = fread(dst, 1, bytes, in);
+    if (got == bytes) return 0;
+    if (last && bytes - got <= view->stride - (size_t)view->width * view->channels) {
+        memset(dst + got, 0, bytes - got);
+        return 0;
+    }
+    fprintf(stderr, "Error: Pixel data ends before the last row.\n");
+    return 1;
+}
+
+// Writes finished rows with zero padding (point operations also map the padding bytes)
+static int stream_write_rows(FILE *out, uint8_t *rows, int count, const t_image_view *view) {
+    size_t row_bytes = (size_t)view->width * view->channels;
+    for (int y = 0; y < count; y++) {
+        memset(rows + (size_t)y * view->stride + row_bytes, 0, view->stride - row_bytes);
+    }
+    if (fwrite(rows, view->stride, count, out) != (size_t)count) {
+        perror("Error writing pixel data");
+        return 1;
+    }
+    return 0;
+}
+
+// Same strips as run_stages, but the input rows are read from `in` as the strips
+// need them and the finished rows are written to `out`. Between two strips only
+// the (at most 2 * halo) original rows the next strip starts with are kept.
+static int stream_stages(FILE *in, FILE *out, const t_image_view *view, const t_stage *stages, int numStages) {
+    size_t stride = view->stride;
+    int height = view->height;
+    int halo = stages_halo(stages, numStages);
+    int strip_rows = strip_rows_for(stride, halo);
+
+    size_t buffer_size = (size_t)(strip_rows + 2 * halo) * stride;
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    uint8_t *buffers[2] = {(uint8_t *)arena_alloc(arena, buffer_size),
+                           halo ? (uint8_t *)arena_alloc(arena, buffer_size) : NULL};
+    uint8_t *kept = halo ? (uint8_t *)arena_alloc(arena, 2 * (size_t)halo * stride) : NULL;
+    if (!buffers[0] || (halo && (!buffers[1] || !kept))) {
+        perror("Error allocating pipeline strips");
+        arena_release(arena, mark);
+        return 1;
+    }
+
+    int status = 0;
+    int loaded = 0; // Rows read from the file so far
+    for (int y0 = 0; y0 < height && status == 0; y0 += strip_rows) {
+        int y1 = (y0 + strip_rows < height) ? y0 + strip_rows : height;
+        int lo = (y0 > halo) ? y0 - halo : 0;
+        int hi = (y1 + halo < height) ? y1 + halo : height;
+
+        // Original rows [lo, loaded) come from the previous strip
+        int kept_rows = loaded - lo;
+        if (kept_rows > 0) memcpy(buffers[0], kept, (size_t)kept_rows * stride);
+        status = stream_read_rows(in, buffers[0] + (size_t)kept_rows * stride, hi - loaded, hi == height, view);
+        if (status != 0) break;
+        loaded = hi;
+
+        if (y1 < height && halo) {
+            int next_lo = (y1 > halo) ? y1 - halo : 0;
+            memcpy(kept, buffers[0] + (size_t)(next_lo - lo) * stride, (size_t)(hi - next_lo) * stride);
+        }
+
+        uint8_t *result = strip_apply(view, stages, numStages, buffers, lo, hi);
+        status = stream_write_rows(out, result + (size_t)(y0 - lo) * stride, y1 - y0, view);
+    }
+
+    arena_release(arena, mark);
+    return status;
+}
+
+// K[k - 1 - ky][kx]. Free with free_kernel.
+static float **flip_kernel_rows(float **kernel, int kernelSize) {
+    float **flipped = allocate_kernel(kernelSize);
+    if (!flipped) return NULL;
+    for (int ky = 0; ky < kernelSize; ky++) {
+        memcpy(flipped[ky], kernel[kernelSize - 1 - ky], kernelSize * sizeof(float));
+    }
+    return flipped;
+}
+
+int pipeline_stream(t_pipeline *pipe, const char *input, const char *output) {
+    if (!pipe || !input || !output) return 1;
+    for (int i = 0; i < pipe->numOps; i++) {
+        if (is_barrier(pipe->ops[i].kind)) {
+            fprintf(stderr, "Error: Equalization needs the whole image and cannot be streamed.\n");
+            return 1;
+        }
+    }
+
+    // Opening the output for writing would truncate the input it is read from
+    if (strcmp(input, output) == 0 || file_isSame(input, output)) {
+        fprintf(stderr, "Error: %s cannot be streamed onto itself.\n", input);
+        return 1;
+    }
+    FILE *in = fopen(input, "rb");
+    if (!in) {
+        perror("Error opening file for reading");
+        return 1;
+    }
+    uint8_t header[54];
+    if (fread(header, 1, sizeof(header), in) != sizeof(header) || header[0] != 'B' || header[1] != 'M') {
+        fprintf(stderr, "%s is not a valid BMP file.\n", input);
+        fclose(in);
+        return 1;
+    }
+    uint32_t offset, compression;
+    int32_t width, height;
+    uint16_t depth;
+    memcpy(&offset, header + BITMAP_OFFSET, sizeof(offset));
+    memcpy(&width, header + BITMAP_WIDTH, sizeof(width));
+    memcpy(&height, header + BITMAP_HEIGHT, sizeof(height));
+    memcpy(&depth, header + BITMAP_DEPTH, sizeof(depth));
+    memcpy(&compression, header + BITMAP_COMPRESSION, sizeof(compression));
+    if ((depth != 8 && depth != 24) || compression != 0 || width <= 0 || height == 0 || height == INT32_MIN ||
+        offset < sizeof(header)) {
+        fprintf(stderr, "%s: only uncompressed 8-bit and 24-bit BMP files can be streamed.\n", input);
+        fclose(in);
+        return 1;
+    }
+    int channels = depth / 8;
+    t_image_view view = {NULL, width, abs(height), ((size_t)width * channels + 3) & ~(size_t)3, channels};
+    if (check_box_radii(pipe, view.width, view.height) != 0) {
+        fclose(in);
+        return 1;
+    }
+
+    // The pixels must start inside the file: a corrupt offset is rejected here
+    // instead of sizing a copy of the headers
+    long file_size = -1;
+    if (fseek(in, 0, SEEK_END) == 0) file_size = ftell(in);
+    if (file_size < 0 || (uint64_t)offset > (uint64_t)file_size || fseek(in, sizeof(header), SEEK_SET) != 0) {
+        fprintf(stderr, "%s: truncated headers.\n", input);
+        fclose(in);
+        return 1;
+    }
+
+    t_arena *arena = scratch_arena();
+    size_t mark = arena_mark(arena);
+    t_stage *stages = (t_stage *)arena_alloc(arena, (pipe->numOps + 1) * sizeof(t_stage));
+    FILE *out = NULL;
+    int numStages = 0, flip = 0, status = 1;
+    if (!stages) {
+        perror("Error allocating pipeline stream");
+        goto done;
+    }
+    out = fopen(output, "wb");
+    if (!out) {
+        perror("Error opening file for writing");
+        goto done;
+    }
+    // Headers and palette are copied as they are, a block at a time
+    if (fwrite(header, 1, sizeof(header), out) != sizeof(header)) {
+        perror("Error writing headers");
+        goto done;
+    }
+    for (uint32_t copied = sizeof(header); copied < offset;) {
+        uint8_t block[4096];
+        size_t n = (offset - copied < sizeof(block)) ? offset - copied : sizeof(block);
+        if (fread(block, 1, n, in) != n) {
+            fprintf(stderr, "%s: truncated headers.\n", input);
+            goto done;
+        }
+        if (fwrite(block, 1, n, out) != n) {
+            perror("Error writing headers");
+            goto done;
+        }
+        copied += (uint32_t)n;
+    }
+
+    numStages = build_stages(pipe->ops, pipe->numOps, channels, stages);
+    // The filters see 24-bit images top-down; a bottom-up file streams upside
+    // down, so its kernels are flipped vertically to match
+    flip = (channels == 3 && height > 0);
+    for (int s = 0; s < numStages; s++) {
+        if (!flip || stages[s].kind != STAGE_CONVOLVE) continue;
+        float **flipped = flip_kernel_rows(stages[s].kernel, stages[s].kernelSize);
+        if (!flipped) {
+            perror("Error allocating flipped kernel");
+            numStages = s; // Only the kernels before this one are owned
+            goto done;
+        }
+        stages[s].kernel = flipped;
+    }
+
+    status = stream_stages(in, out, &view, stages, numStages);
+
+done:
+    for (int s = 0; flip && s < numStages; s++) {
+        if (stages[s].kind == STAGE_CONVOLVE) free_kernel(stages[s].kernel, stages[s].kernelSize);
+    }
+    arena_release(arena, mark);
+    fclose(in);
+    if (out && fclose(out) != 0) status = 1;
+    if (status == 0) {
+        printf("Pipeline streamed: %d operation(s), image saved as %s.\n", pipe->numOps, output);
+    }
+    pipe->numOps = 0;
+    return status;
+}
@@ -0,0 +1,88 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "bmp8.h"
+#include "bmp24.h"
+#include "bmp32.h"
+#include "lut.h"
+
+// Deferred processing of one image.
+//
+// The pipeline_* calls only record the operation; nothing touches the pixels
+// until pipeline_materialize (or pipeline_save). The recorded chain is then run
+// as a few fused passes:
+//   - adjacent point operations (negative, brightness, threshold) run on the
+//     vector kernels of pixelops.h, or become one lookup table (lut.h) when the
+//     chain is longer than PIPELINE_POINT_KERNELS_MAX (8);
+//   - point operations, grayscale and convolutions between two equalizations are
+//     streamed through the image in horizontal strips: every strip goes through
+//     the whole chain while it is in cache, with enough halo rows for the
+//     kernels, so no full-size temporary image is allocated; large images are
+//     split into one band of strips per thread;
+//   - equalization and CLAHE need the histogram of the whole image and run on
+//     their own between the strip passes.
+// The result is the same as calling the bmp8_* / bmp24_* / bmp32_* functions in order.
+
+typedef enum {
+    PIPE_NEGATIVE, PIPE_BRIGHTNESS, PIPE_THRESHOLD, PIPE_GRAYSCALE,
+    PIPE_FILTER, PIPE_BOX_RADIUS, PIPE_EQUALIZE, PIPE_CLAHE
+} t_pipeline_op_kind;
+
+typedef struct {
+    t_pipeline_op_kind kind;
+    int value;          // Brightness delta, threshold, radius or CLAHE tiles
+    float clipLimit;    // CLAHE only
+    float **kernel;     // PIPE_FILTER only (not copied: must stay valid until materialized)
+    int kernelSize;
+} t_pipeline_op;
+
+typedef struct {
+    t_bmp8 *img8;       // At most one of img8 / img24 / img32 is set (not owned by the pipeline)
+    t_bmp24 *img24;
+    t_bmp32 *img32;
+    t_pipeline_op *ops; // Recorded, not yet executed
+    int numOps;
+    int capacity;
+} t_pipeline;
+
+// Creates an empty pipeline over an image. Returns NULL on error; release with pipeline_free.
+t_pipeline *pipeline_create8(t_bmp8 *img);
+t_pipeline *pipeline_create24(t_bmp24 *img);
+t_pipeline *pipeline_create32(t_bmp32 *img);
+
+// Pipeline without an image, for pipeline_stream
+t_pipeline *pipeline_createStream(void);
+void pipeline_free(t_pipeline *pipe);
+
+// Recording (each returns 0, or 1 if the operation could not be recorded)
+int pipeline_negative(t_pipeline *pipe);
+int pipeline_brightness(t_pipeline *pipe, int value);
+int pipeline_threshold(t_pipeline *pipe, int threshold);
+int pipeline_grayscale(t_pipeline *pipe);  // No-op on 8-bit images
+int pipeline_filter(t_pipeline *pipe, float **kernel, int kernelSize);
+int pipeline_boxBlur(t_pipeline *pipe);
+int pipeline_gaussianBlur(t_pipeline *pipe);
+int pipeline_outline(t_pipeline *pipe);
+int pipeline_emboss(t_pipeline *pipe);
+int pipeline_sharpen(t_pipeline *pipe);
+int pipeline_boxBlurRadius(t_pipeline *pipe, int radius);
+int pipeline_equalize(t_pipeline *pipe);
+int pipeline_clahe(t_pipeline *pipe, int tiles, float clipLimit);
+
+// Runs the recorded operations on the image and clears the list. Returns 0 on success.
+int pipeline_materialize(t_pipeline *pipe);
+
+// Materializes, then saves the image
+int pipeline_save(t_pipeline *pipe, const char *filename);
+
+// Out-of-core mode: runs the recorded operations from the BMP file `input` to
+// `output` without loading the image. Rows are read as the strips need them and
+// written as soon as they are final, so memory stays around two 512 KB strips
+// plus (width x total kernel height) whatever the image height. 8-bit and 24-bit
+// uncompressed files; equalization and CLAHE need the whole image and are
+// refused. The result is the same as loading, filtering and saving (bottom-up
+// 24-bit files use vertically flipped kernels, which only changes the float
+// rounding of asymmetric kernels). Clears the list; returns 0 on success.
+int pipeline_stream(t_pipeline *pipe, const char *input, const char *output);
+
+#endif // PIPELINE_H
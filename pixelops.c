@@ -0,0 +1,363 @@
+#include "pixelops.h"
+
+#include <pthread.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PIXELOPS_X86 1
+#include <immintrin.h>
+#endif
+
+// Buffers below this size are not worth handing to other threads
+#define PIXELOPS_PARALLEL_MIN (1u << 20)
+
+typedef enum { OP_NEGATIVE, OP_BRIGHTNESS, OP_THRESHOLD, OP_LUT } t_point_op;
+
+// Every function below gets `keep_alpha`: when set, data holds R,G,B,A pixels and
+// starts on a pixel, and the fourth byte of each pixel is left as it is. The
+// vector versions do this with a per-lane mask, at the same speed.
+
+// Byte mask of the bytes an operation changes in each 32-bit lane (little-endian)
+#define POINT_LANES(keep_alpha) ((keep_alpha) ? 0x00FFFFFF : -1)
+
+// --- Scalar implementations (also used for the tails of the vector loops) ---
+
+// Map through `map`, skipping the alpha bytes when keep_alpha is set
+static void map_scalar(uint8_t *data, size_t n, const uint8_t *map, int keep_alpha) {
+    if (keep_alpha) {
+        for (size_t i = 0; i < n; i++) {
+            if ((i & 3) != 3) data[i] = map[data[i]];
+        }
+        return;
+    }
+    for (size_t i = 0; i < n; i++) data[i] = map[data[i]];
+}
+
+static void negative_scalar(uint8_t *data, size_t n, int keep_alpha) {
+    if (keep_alpha) {
+        for (size_t i = 0; i < n; i++) {
+            if ((i & 3) != 3) data[i] = (uint8_t)(255 - data[i]);
+        }
+        return;
+    }
+    for (size_t i = 0; i < n; i++) data[i] = (uint8_t)(255 - data[i]);
+}
+
+static void brightness_scalar(uint8_t *data, size_t n, int value, int keep_alpha) {
+    // Build the mapping once instead of clamping every pixel
+    uint8_t map[256];
+    for (int v = 0; v < 256; v++) map[v] = (uint8_t)clamp_int(v + value, 0, 255);
+    map_scalar(data, n, map, keep_alpha);
+}
+
+static void threshold_scalar(uint8_t *data, size_t n, int threshold, int keep_alpha) {
+    if (keep_alpha) {
+        for (size_t i = 0; i < n; i++) {
+            if ((i & 3) != 3) data[i] = (data[i] >= threshold) ? 255 : 0;
+        }
+        return;
+    }
+    for (size_t i = 0; i < n; i++) data[i] = (data[i] >= threshold) ? 255 : 0;
+}
+
+// Shared by every implementation: a 256-entry lookup has no faster vector form
+// without AVX-512 (a 16-way pshufb version measured no faster than this loop)
+static void lut_scalar(uint8_t *data, size_t n, const uint8_t *table, int keep_alpha) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint8_t a = table[data[i]], b = table[data[i + 1]], c = table[data[i + 2]];
+        uint8_t d = keep_alpha ? data[i + 3] : table[data[i + 3]];
+        data[i] = a;
+        data[i + 1] = b;
+        data[i + 2] = c;
+        data[i + 3] = d;
+    }
+    map_scalar(data + i, n - i, table, keep_alpha);
+}
+
+static void deinterleave3_scalar(const uint8_t *src, uint8_t *p0, uint8_t *p1, uint8_t *p2, size_t n) {
+    for (size_t i = 0; i < n; i++, src += 3) {
+        p0[i] = src[0];
+        p1[i] = src[1];
+        p2[i] = src[2];
+    }
+}
+
+static void interleave3_scalar(const uint8_t *p0, const uint8_t *p1, const uint8_t *p2, uint8_t *dst, size_t n) {
+    for (size_t i = 0; i < n; i++, dst += 3) {
+        dst[0] = p0[i];
+        dst[1] = p1[i];
+        dst[2] = p2[i];
+    }
+}
+
+#ifdef PIXELOPS_X86
+
+// --- SSE2 (16 bytes per step) ---
+
+__attribute__((target("sse2")))
+static void negative_sse2(uint8_t *data, size_t n, int keep_alpha) {
+    const __m128i ones = _mm_set1_epi32(POINT_LANES(keep_alpha));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        _mm_storeu_si128((__m128i *)(data + i), _mm_xor_si128(v, ones)); // 255 - v == ~v
+    }
+    negative_scalar(data + i, n - i, keep_alpha);
+}
+
+__attribute__((target("sse2")))
+static void brightness_sse2(uint8_t *data, size_t n, int value, int keep_alpha) {
+    // Adding or subtracting 0 leaves the alpha bytes as they are
+    const __m128i delta = _mm_and_si128(_mm_set1_epi8((char)(uint8_t)abs(value)), _mm_set1_epi32(POINT_LANES(keep_alpha)));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        v = (value >= 0) ? _mm_adds_epu8(v, delta) : _mm_subs_epu8(v, delta);
+        _mm_storeu_si128((__m128i *)(data + i), v);
+    }
+    brightness_scalar(data + i, n - i, value, keep_alpha);
+}
+
+__attribute__((target("sse2")))
+static void threshold_sse2(uint8_t *data, size_t n, int threshold, int keep_alpha) {
+    const __m128i t = _mm_set1_epi8((char)(uint8_t)threshold);
+    const __m128i lanes = _mm_set1_epi32(POINT_LANES(keep_alpha));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        // Unsigned v >= t  <=>  max(v, t) == v; the compare yields 0xFF / 0x00 directly
+        __m128i r = _mm_cmpeq_epi8(_mm_max_epu8(v, t), v);
+        _mm_storeu_si128((__m128i *)(data + i), _mm_or_si128(_mm_and_si128(r, lanes), _mm_andnot_si128(lanes, v)));
+    }
+    threshold_scalar(data + i, n - i, threshold, keep_alpha);
+}
+
+// --- AVX2 (32 bytes per step) ---
+
+__attribute__((target("avx2")))
+static void negative_avx2(uint8_t *data, size_t n, int keep_alpha) {
+    const __m256i ones = _mm256_set1_epi32(POINT_LANES(keep_alpha));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        _mm256_storeu_si256((__m256i *)(data + i), _mm256_xor_si256(v, ones));
+    }
+    negative_scalar(data + i, n - i, keep_alpha);
+}
+
+__attribute__((target("avx2")))
+static void brightness_avx2(uint8_t *data, size_t n, int value, int keep_alpha) {
+    const __m256i delta = _mm256_and_si256(_mm256_set1_epi8((char)(uint8_t)abs(value)),
+                                           _mm256_set1_epi32(POINT_LANES(keep_alpha)));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        v = (value >= 0) ? _mm256_adds_epu8(v, delta) : _mm256_subs_epu8(v, delta);
+        _mm256_storeu_si256((__m256i *)(data + i), v);
+    }
+    brightness_scalar(data + i, n - i, value, keep_alpha);
+}
+
+__attribute__((target("avx2")))
+static void threshold_avx2(uint8_t *data, size_t n, int threshold, int keep_alpha) {
+    const __m256i t = _mm256_set1_epi8((char)(uint8_t)threshold);
+    const __m256i lanes = _mm256_set1_epi32(POINT_LANES(keep_alpha));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i r = _mm256_cmpeq_epi8(_mm256_max_epu8(v, t), v);
+        _mm256_storeu_si256((__m256i *)(data + i), _mm256_blendv_epi8(v, r, lanes));
+    }
+    threshold_scalar(data + i, n - i, threshold, keep_alpha);
+}
+
+// --- SSSE3 (16 pixels per step; every AVX2 CPU has it) ---
+
+// pshufb masks: X clears the byte
+#define X -128
+// Plane c takes bytes from source vectors 0, 1, 2: DEINTERLEAVE3[c * 3 + k]
+static const int8_t DEINTERLEAVE3[9][16] = {
+    {0, 3, 6, 9, 12, 15, X, X, X, X, X, X, X, X, X, X},
+    {X, X, X, X, X, X, 2, 5, 8, 11, 14, X, X, X, X, X},
+    {X, X, X, X, X, X, X, X, X, X, X, 1, 4, 7, 10, 13},
+    {1, 4, 7, 10, 13, X, X, X, X, X, X, X, X, X, X, X},
+    {X, X, X, X, X, 0, 3, 6, 9, 12, 15, X, X, X, X, X},
+    {X, X, X, X, X, X, X, X, X, X, X, 2, 5, 8, 11, 14},
+    {2, 5, 8, 11, 14, X, X, X, X, X, X, X, X, X, X, X},
+    {X, X, X, X, X, 1, 4, 7, 10, 13, X, X, X, X, X, X},
+    {X, X, X, X, X, X, X, X, X, X, 0, 3, 6, 9, 12, 15},
+};
+// Output vector k takes bytes from planes 0, 1, 2: INTERLEAVE3[k * 3 + c]
+static const int8_t INTERLEAVE3[9][16] = {
+    {0, X, X, 1, X, X, 2, X, X, 3, X, X, 4, X, X, 5},
+    {X, 0, X, X, 1, X, X, 2, X, X, 3, X, X, 4, X, X},
+    {X, X, 0, X, X, 1, X, X, 2, X, X, 3, X, X, 4, X},
+    {X, X, 6, X, X, 7, X, X, 8, X, X, 9, X, X, 10, X},
+    {5, X, X, 6, X, X, 7, X, X, 8, X, X, 9, X, X, 10},
+    {X, 5, X, X, 6, X, X, 7, X, X, 8, X, X, 9, X, X},
+    {X, 11, X, X, 12, X, X, 13, X, X, 14, X, X, 15, X, X},
+    {X, X, 11, X, X, 12, X, X, 13, X, X, 14, X, X, 15, X},
+    {10, X, X, 11, X, X, 12, X, X, 13, X, X, 14, X, X, 15},
+};
+#undef X
+
+__attribute__((target("ssse3")))
+static inline __m128i shuffle3_ssse3(__m128i a, __m128i b, __m128i c, const int8_t masks[3][16]) {
+    __m128i r = _mm_shuffle_epi8(a, _mm_loadu_si128((const __m128i *)masks[0]));
+    r = _mm_or_si128(r, _mm_shuffle_epi8(b, _mm_loadu_si128((const __m128i *)masks[1])));
+    return _mm_or_si128(r, _mm_shuffle_epi8(c, _mm_loadu_si128((const __m128i *)masks[2])));
+}
+
+__attribute__((target("ssse3")))
+static void deinterleave3_ssse3(const uint8_t *src, uint8_t *p0, uint8_t *p1, uint8_t *p2, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, src += 48) {
+        __m128i a = _mm_loadu_si128((const __m128i *)src);
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+        _mm_storeu_si128((__m128i *)(p0 + i), shuffle3_ssse3(a, b, c, DEINTERLEAVE3 + 0));
+        _mm_storeu_si128((__m128i *)(p1 + i), shuffle3_ssse3(a, b, c, DEINTERLEAVE3 + 3));
+        _mm_storeu_si128((__m128i *)(p2 + i), shuffle3_ssse3(a, b, c, DEINTERLEAVE3 + 6));
+    }
+    deinterleave3_scalar(src, p0 + i, p1 + i, p2 + i, n - i);
+}
+
+__attribute__((target("ssse3")))
+static void interleave3_ssse3(const uint8_t *p0, const uint8_t *p1, const uint8_t *p2, uint8_t *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, dst += 48) {
+        __m128i r = _mm_loadu_si128((const __m128i *)(p0 + i));
+        __m128i g = _mm_loadu_si128((const __m128i *)(p1 + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(p2 + i));
+        _mm_storeu_si128((__m128i *)dst, shuffle3_ssse3(r, g, b, INTERLEAVE3 + 0));
+        _mm_storeu_si128((__m128i *)(dst + 16), shuffle3_ssse3(r, g, b, INTERLEAVE3 + 3));
+        _mm_storeu_si128((__m128i *)(dst + 32), shuffle3_ssse3(r, g, b, INTERLEAVE3 + 6));
+    }
+    interleave3_scalar(p0 + i, p1 + i, p2 + i, dst, n - i);
+}
+
+#endif // PIXELOPS_X86
+
+// --- Dispatch ---
+
+typedef struct {
+    const char *name;
+    void (*negative)(uint8_t *, size_t, int);
+    void (*brightness)(uint8_t *, size_t, int, int);
+    void (*threshold)(uint8_t *, size_t, int, int);
+    void (*deinterleave3)(const uint8_t *, uint8_t *, uint8_t *, uint8_t *, size_t);
+    void (*interleave3)(const uint8_t *, const uint8_t *, const uint8_t *, uint8_t *, size_t);
+} t_pixelops_impl;
+
+static const t_pixelops_impl impl_scalar = {"scalar", negative_scalar, brightness_scalar, threshold_scalar,
+                                            deinterleave3_scalar, interleave3_scalar};
+#ifdef PIXELOPS_X86
+static const t_pixelops_impl impl_sse2 = {"sse2", negative_sse2, brightness_sse2, threshold_sse2,
+                                          deinterleave3_scalar, interleave3_scalar};
+static const t_pixelops_impl impl_avx2 = {"avx2", negative_avx2, brightness_avx2, threshold_avx2,
+                                          deinterleave3_ssse3, interleave3_ssse3};
+#endif
+
+static const t_pixelops_impl *chosen_impl = &impl_scalar;
+static pthread_once_t chosen_once = PTHREAD_ONCE_INIT;
+
+static void choose_impl(void) {
+#ifdef PIXELOPS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) chosen_impl = &impl_avx2;
+    else if (__builtin_cpu_supports("sse2")) chosen_impl = &impl_sse2;
+#endif
+}
+
+// The first call picks the implementation; calls racing with it wait until it is set
+static const t_pixelops_impl *pixelops_impl(void) {
+    pthread_once(&chosen_once, choose_impl);
+    return chosen_impl;
+}
+
+const char *u8_simd_level(void) {
+    return pixelops_impl()->name;
+}
+
+typedef struct {
+    uint8_t *data;
+    size_t n;
+    size_t chunk;
+    t_point_op op;
+    int value;
+    const uint8_t *table;   // OP_LUT only
+    int keep_alpha;
+} t_pixelops_job;
+
+static void run_point_op(uint8_t *data, size_t n, t_point_op op, int value, const uint8_t *table, int keep_alpha) {
+    const t_pixelops_impl *impl = pixelops_impl();
+    switch (op) {
+        case OP_NEGATIVE: impl->negative(data, n, keep_alpha); break;
+        case OP_BRIGHTNESS: impl->brightness(data, n, value, keep_alpha); break;
+        case OP_THRESHOLD: impl->threshold(data, n, value, keep_alpha); break;
+        case OP_LUT: lut_scalar(data, n, table, keep_alpha); break;
+    }
+}
+
+static void point_op_chunks(int begin, int end, void *arg) {
+    t_pixelops_job *job = (t_pixelops_job *)arg;
+    size_t from = (size_t)begin * job->chunk;
+    size_t to = (size_t)end * job->chunk;
+    if (to > job->n) to = job->n;
+    run_point_op(job->data + from, to - from, job->op, job->value, job->table, job->keep_alpha);
+}
+
+static void point_op(uint8_t *data, size_t n, t_point_op op, int value, const uint8_t *table, int keep_alpha) {
+    if (!data || n == 0) return;
+    if (n < PIXELOPS_PARALLEL_MIN) {
+        run_point_op(data, n, op, value, table, keep_alpha);
+        return;
+    }
+    // Chunks are multiples of a cache line so threads never share one (and start on a pixel)
+    t_pixelops_job job = {data, n, PIXELOPS_PARALLEL_MIN / 4, op, value, table, keep_alpha};
+    parallel_for(0, (int)((n + job.chunk - 1) / job.chunk), point_op_chunks, &job);
+}
+
+void u8_negative(uint8_t *data, size_t n) {
+    point_op(data, n, OP_NEGATIVE, 0, NULL, 0);
+}
+
+void u8_brightness(uint8_t *data, size_t n, int value) {
+    point_op(data, n, OP_BRIGHTNESS, clamp_int(value, -255, 255), NULL, 0);
+}
+
+void u8_threshold(uint8_t *data, size_t n, int threshold) {
+    point_op(data, n, OP_THRESHOLD, clamp_int(threshold, 0, 255), NULL, 0);
+}
+
+void u8_lut(uint8_t *data, size_t n, const uint8_t *table) {
+    if (!table) return;
+    point_op(data, n, OP_LUT, 0, table, 0);
+}
+
+void rgba_negative(uint8_t *data, size_t n) {
+    point_op(data, n, OP_NEGATIVE, 0, NULL, 1);
+}
+
+void rgba_brightness(uint8_t *data, size_t n, int value) {
+    point_op(data, n, OP_BRIGHTNESS, clamp_int(value, -255, 255), NULL, 1);
+}
+
+void rgba_threshold(uint8_t *data, size_t n, int threshold) {
+    point_op(data, n, OP_THRESHOLD, clamp_int(threshold, 0, 255), NULL, 1);
+}
+
+void rgba_lut(uint8_t *data, size_t n, const uint8_t *table) {
+    if (!table) return;
+    point_op(data, n, OP_LUT, 0, table, 1);
+}
+
+void u8_deinterleave3(const uint8_t *src, uint8_t *p0, uint8_t *p1, uint8_t *p2, size_t n) {
+    if (!src || !p0 || !p1 || !p2) return;
+    pixelops_impl()->deinterleave3(src, p0, p1, p2, n);
+}
+
+void u8_interleave3(const uint8_t *p0, const uint8_t *p1, const uint8_t *p2, uint8_t *dst, size_t n) {
+    if (!p0 || !p1 || !p2 || !dst) return;
+    pixelops_impl()->interleave3(p0, p1, p2, dst, n);
+}
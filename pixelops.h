@@ -0,0 +1,44 @@
+#ifndef PIXELOPS_H
+#define PIXELOPS_H
+
+#include "utils.h"
+
+// Vectorized point operations on raw 8-bit buffers.
+//
+// Every function works on `n` consecutive bytes, whatever they represent
+// (grayscale pixels, interleaved R,G,B channels, ...). The implementation is
+// picked once at run time from the CPU features: AVX2, SSE2, or a portable
+// scalar loop. Large buffers are additionally split across threads.
+
+// data[i] = 255 - data[i]
+void u8_negative(uint8_t *data, size_t n);
+
+// data[i] = clamp(data[i] + value, 0, 255), using saturating byte arithmetic
+void u8_brightness(uint8_t *data, size_t n, int value);
+
+// data[i] = (data[i] >= threshold) ? 255 : 0, threshold clamped to [0, 255]
+void u8_threshold(uint8_t *data, size_t n, int threshold);
+
+// data[i] = table[data[i]] for a 256-entry table. Plain table lookups in every
+// implementation (there is no faster vector form without AVX-512), split across
+// threads like the others.
+void u8_lut(uint8_t *data, size_t n, const uint8_t *table);
+
+// Same operations on R,G,B,A pixels: n is a multiple of 4 and the fourth byte
+// of every pixel (alpha) is left as it is. The vector versions mask the alpha
+// lane, so they run at the speed of the u8_* versions.
+void rgba_negative(uint8_t *data, size_t n);
+void rgba_brightness(uint8_t *data, size_t n, int value);
+void rgba_threshold(uint8_t *data, size_t n, int threshold);
+void rgba_lut(uint8_t *data, size_t n, const uint8_t *table);
+
+// Splits n 3-byte pixels into three planes (p0[i] = src[3i], p1[i] = src[3i + 1],
+// p2[i] = src[3i + 2]) and back. Byte shuffles on AVX2 machines; not threaded,
+// callers split the work by rows.
+void u8_deinterleave3(const uint8_t *src, uint8_t *p0, uint8_t *p1, uint8_t *p2, size_t n);
+void u8_interleave3(const uint8_t *p0, const uint8_t *p1, const uint8_t *p2, uint8_t *dst, size_t n);
+
+// Name of the implementation in use ("avx2", "sse2" or "scalar")
+const char *u8_simd_level(void);
+
+#endif // PIXELOPS_H
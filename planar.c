@@ -0,0 +1,144 @@
+#include "planar.h"
+#include "convolution.h"
+#include "pixelops.h"
+
+// Images below this many bytes are split / merged on the calling thread
+#define PLANAR_PARALLEL_MIN (1u << 20)
+
+// --- Allocation and Deallocation Functions ---
+
+t_planar24 *planar24_allocate(int width, int height) {
+    if (width <= 0 || height <= 0) return NULL;
+    t_planar24 *img = (t_planar24 *)calloc(1, sizeof(t_planar24));
+    // Rounding the planes up keeps each of them on a cache line of its own
+    size_t planeSize = ((size_t)width * height + PLANAR24_ALIGNMENT - 1) / PLANAR24_ALIGNMENT * PLANAR24_ALIGNMENT;
+    uint8_t *raw = (uint8_t *)calloc(planeSize * PLANAR24_PLANES + PLANAR24_ALIGNMENT, 1);
+    if (!img || !raw) {
+        perror("Failed to allocate t_planar24");
+        free(img);
+        free(raw);
+        return NULL;
+    }
+
+    img->width = width;
+    img->height = height;
+    img->planeSize = planeSize;
+    img->raw = raw;
+    img->buffer = raw + (PLANAR24_ALIGNMENT - (uintptr_t)raw % PLANAR24_ALIGNMENT) % PLANAR24_ALIGNMENT;
+    for (int c = 0; c < PLANAR24_PLANES; c++) {
+        img->planes[c] = img->buffer + c * planeSize;
+    }
+    return img;
+}
+
+void planar24_free(t_planar24 *img) {
+    if (!img) return;
+    free(img->raw);
+    free(img);
+}
+
+// --- Conversion ---
+
+typedef struct {
+    t_bmp24 *img;
+    const t_planar24 *planar;
+} t_planar_job;
+
+static void planar_split_rows(int begin, int end, void *ctx) {
+    const t_planar_job *job = (const t_planar_job *)ctx;
+    const t_planar24 *p = job->planar;
+    // A mapped image not written to yet is read in its file layout (B,G,R, maybe bottom-up)
+    int file = job->img->fileLayout;
+    int bottom_up = file && job->img->info.height > 0;
+    uint8_t *first = p->planes[file ? 2 : 0], *last = p->planes[file ? 0 : 2];
+    for (int y = begin; y < end; y++) {
+        size_t offset = (size_t)y * p->width;
+        int src = bottom_up ? p->height - 1 - y : y;
+        u8_deinterleave3(job->img->pixels + src * job->img->stride,
+                         first + offset, p->planes[1] + offset, last + offset, p->width);
+    }
+}
+
+static void planar_merge_rows(int begin, int end, void *ctx) {
+    const t_planar_job *job = (const t_planar_job *)ctx;
+    const t_planar24 *p = job->planar;
+    for (int y = begin; y < end; y++) {
+        size_t offset = (size_t)y * p->width;
+        u8_interleave3(p->planes[0] + offset, p->planes[1] + offset, p->planes[2] + offset,
+                       job->img->pixels + y * job->img->stride, p->width);
+    }
+}
+
+static int planar_run(t_bmp24 *img, const t_planar24 *planar, t_range_fn rows) {
+    if (!img || !img->pixels || !planar) return 1;
+    if (img->info.width != planar->width || abs(img->info.height) != planar->height) {
+        fprintf(stderr, "Error: Planar image is %dx%d, not %dx%d.\n",
+                planar->width, planar->height, img->info.width, abs(img->info.height));
+        return 1;
+    }
+
+    t_planar_job job = {img, planar};
+    if (planar->planeSize * PLANAR24_PLANES < PLANAR_PARALLEL_MIN) {
+        rows(0, planar->height, &job);
+    } else {
+        parallel_for(0, planar->height, rows, &job);
+    }
+    return 0;
+}
+
+int bmp24_splitPlanes(const t_bmp24 *img, t_planar24 *planar) {
+    // The rows are only read
+    return planar_run((t_bmp24 *)img, planar, planar_split_rows);
+}
+
+int bmp24_mergePlanes(t_bmp24 *img, const t_planar24 *planar) {
+    if (img && img->pixels && bmp24_makeWritable(img) != 0) return 1;
+    return planar_run(img, planar, planar_merge_rows);
+}
+
+t_planar24 *bmp24_toPlanar(const t_bmp24 *img) {
+    if (!img || !img->pixels) return NULL;
+    t_planar24 *planar = planar24_allocate(img->info.width, abs(img->info.height));
+    if (!planar) return NULL;
+    if (bmp24_splitPlanes(img, planar) != 0) {
+        planar24_free(planar);
+        return NULL;
+    }
+    return planar;
+}
+
+// --- Per-plane operations ---
+
+void planar24_negative(t_planar24 *img) {
+    if (!img) return;
+    // The planes are back to back: one sweep (the padding between them is unused)
+    u8_negative(img->buffer, img->planeSize * PLANAR24_PLANES);
+}
+
+void planar24_brightness(t_planar24 *img, int value) {
+    if (!img) return;
+    u8_brightness(img->buffer, img->planeSize * PLANAR24_PLANES, value);
+}
+
+void planar24_applyFilter(t_planar24 *img, float **kernel, int kernelSize) {
+    if (!img || !kernel || kernelSize <= 0 || kernelSize % 2 == 0) {
+        fprintf(stderr, "Error: Invalid arguments for planar24_applyFilter.\n");
+        return;
+    }
+
+    // Each plane is convolved like a t_bmp8 (bmp8_applyFilter), borders untouched
+    for (int c = 0; c < PLANAR24_PLANES; c++) {
+        convolve_inplace_u8(img->planes[c], img->width, img->height, img->width, 1, kernel, kernelSize);
+    }
+}
+
+void planar24_boxBlurRadius(t_planar24 *img, int radius) {
+    if (!img || radius <= 0) {
+        fprintf(stderr, "Error: Invalid arguments for planar24_boxBlurRadius.\n");
+        return;
+    }
+
+    for (int c = 0; c < PLANAR24_PLANES; c++) {
+        convolve_box_inplace_u8(img->planes[c], img->width, img->height, img->width, 1, radius);
+    }
+}
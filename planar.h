@@ -0,0 +1,54 @@
+#ifndef PLANAR_H
+#define PLANAR_H
+
+#include "bmp24.h" // For t_bmp24
+
+// Planar (one plane per channel) copy of a 24-bit image.
+//
+// t_bmp24 keeps R, G, B interleaved, so every per-channel loop reads bytes 3
+// apart. Here the red, green and blue values are three separate width x height
+// planes, each an ordinary 8-bit image: the functions below run the 8-bit
+// kernels (pixelops.h, convolution.h, histogram.h) once per plane, on
+// contiguous bytes. Splitting and merging cost about one pass over the image
+// each, so the layout pays off when several operations run in a row.
+
+#define PLANAR24_PLANES 3
+
+typedef struct {
+    int width;
+    int height;
+    size_t planeSize;                   // Bytes per plane: width * height rounded up to 64
+    uint8_t *planes[PLANAR24_PLANES];   // Red, green, blue; top-down rows of `width` bytes
+    uint8_t *buffer;                    // One aligned buffer holding the planes back to back
+    uint8_t *raw;                       // Allocation `buffer` points into
+} t_planar24;
+
+// Alignment of every plane (one cache line)
+#define PLANAR24_ALIGNMENT 64
+
+// New planar image, zeroed. Returns NULL on error; release with planar24_free.
+t_planar24 *planar24_allocate(int width, int height);
+void planar24_free(t_planar24 *img);
+
+// Splits a 24-bit image into a new planar image. Returns NULL on error.
+t_planar24 *bmp24_toPlanar(const t_bmp24 *img);
+
+// Same into an existing planar image of the same size (no allocation). Returns 0 on success.
+int bmp24_splitPlanes(const t_bmp24 *img, t_planar24 *planar);
+
+// Writes the planes back into the interleaved rows of `img` (same size). Returns 0 on success.
+int bmp24_mergePlanes(t_bmp24 *img, const t_planar24 *planar);
+
+// --- Per-plane operations ---
+// Same results as the bmp24_* functions of the same name on the interleaved image.
+void planar24_negative(t_planar24 *img);
+void planar24_brightness(t_planar24 *img, int value);
+void planar24_applyFilter(t_planar24 *img, float **kernel, int kernelSize);
+void planar24_boxBlurRadius(t_planar24 *img, int radius);
+
+// Equalizes every plane on its own histogram (bmp8_equalize per channel).
+// Unlike bmp24_equalize, which equalizes luma only, this stretches each channel
+// independently and can shift hues. Defined in histogram.c.
+void planar24_equalize(t_planar24 *img);
+
+#endif // PLANAR_H
@@ -1,3 +1,11 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "utils.h"
 
 // Predefined kernels
@@ -38,6 +46,39 @@ void file_rawWrite(uint32_t position, void *buffer, uint32_t size, size_t n, FIL
     }
 }
 
+uint8_t *file_mapPrivate(const char *filename, size_t *size) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Error opening file for mapping");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        perror("Error getting file size for mapping");
+        close(fd);
+        return NULL;
+    }
+    // MAP_PRIVATE: filters may write to the pixels, the pages are then copied on write
+    void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after closing the descriptor
+    if (mapping == MAP_FAILED) {
+        perror("Error mapping file");
+        return NULL;
+    }
+    *size = (size_t)st.st_size;
+    return (uint8_t *)mapping;
+}
+
+void file_unmap(uint8_t *mapping, size_t size) {
+    if (mapping) munmap(mapping, size);
+}
+
+int file_isSame(const char *a, const char *b) {
+    struct stat sa, sb;
+    if (!a || !b || stat(a, &sa) != 0 || stat(b, &sb) != 0) return 0;
+    return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
 float **allocate_kernel(int kernelSize) {
     float **kernel = (float **)malloc(kernelSize * sizeof(float *));
     if (!kernel) return NULL;
@@ -61,6 +102,37 @@ void free_kernel(float **kernel, int kernelSize) {
     free(kernel);
 }
 
+float **create_box_kernel(int kernelSize) {
+    float **kernel = allocate_kernel(kernelSize);
+    if (!kernel) return NULL;
+    float val = 1.0f / (float)(kernelSize * kernelSize);
+    for (int i = 0; i < kernelSize; i++) for (int j = 0; j < kernelSize; j++) kernel[i][j] = val;
+    return kernel;
+}
+
+float **create_gaussian_kernel(int kernelSize, float sigma) {
+    float **kernel = allocate_kernel(kernelSize);
+    if (!kernel) return NULL;
+    int n = kernelSize / 2;
+    if (sigma <= 0.0f) sigma = 0.3f * ((kernelSize - 1) * 0.5f - 1.0f) + 0.8f;
+
+    // Built as the outer product of a normalized 1D profile so it is exactly rank-1
+    float *profile = (float *)malloc(kernelSize * sizeof(float));
+    if (!profile) {
+        free_kernel(kernel, kernelSize);
+        return NULL;
+    }
+    float total = 0.0f;
+    for (int i = 0; i < kernelSize; i++) {
+        profile[i] = expf(-(float)((i - n) * (i - n)) / (2.0f * sigma * sigma));
+        total += profile[i];
+    }
+    for (int i = 0; i < kernelSize; i++) profile[i] /= total;
+    for (int i = 0; i < kernelSize; i++) for (int j = 0; j < kernelSize; j++) kernel[i][j] = profile[i] * profile[j];
+    free(profile);
+    return kernel;
+}
+
 void initialize_kernels() {
     // Box Blur
     BOX_BLUR_KERNEL = allocate_kernel(KERNEL_SIZE_3x3);
@@ -99,6 +171,9 @@ void initialize_kernels() {
             { 0, -1,  0}
     };
     for (int i = 0; i < KERNEL_SIZE_3x3; i++) for (int j = 0; j < KERNEL_SIZE_3x3; j++) SHARPEN_KERNEL[i][j] = sharpen_vals[i][j];
+
+    // Workers for parallel_for, ready before the first filter runs
+    thread_pool_start();
 }
 
 void cleanup_kernels() {
@@ -107,6 +182,346 @@ void cleanup_kernels() {
     free_kernel(OUTLINE_KERNEL, KERNEL_SIZE_3x3);
     free_kernel(EMBOSS_KERNEL, KERNEL_SIZE_3x3);
     free_kernel(SHARPEN_KERNEL, KERNEL_SIZE_3x3);
+
+    thread_pool_stop(); // The workers free their arenas as they exit
+    scratch_arena_free();
+}
+
+// --- Parallelism ---
+
+static int num_threads = 0; // 0: not configured, use the CPU count
+
+void set_num_threads(int n) {
+    num_threads = (n > 0) ? n : 0;
+}
+
+int get_num_threads(void) {
+    if (num_threads > 0) return num_threads;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (int)cpus : 1;
+}
+
+// --- Thread pool ---
+// The workers are started once (initialize_kernels, or the first parallel_for)
+// and sleep between jobs, so a filter pays a wake-up instead of creating and
+// joining threads on every call. The pool only grows: a larger set_num_threads
+// adds workers at the next job.
+//
+// A job [begin, end) is cut into one contiguous slice per participant (the
+// calling thread is participant 0). Each participant runs its slice in chunks
+// from the front; once its slice is empty it steals the back half of the
+// largest slice left, so a band that turns out slower is shared out instead of
+// holding everyone up.
+
+// Chunks per participant: more balances better, fewer calls the body less often
+#define POOL_CHUNKS_PER_THREAD 4
+
+typedef struct {
+    int next;   // First index not handed out yet
+    int end;
+} t_slice;
+
+typedef struct {
+    pthread_t tid;
+    unsigned long generation;   // Last job the worker has seen (the current one when it is started)
+} t_worker;
+
+static struct {
+    pthread_mutex_t lock;       // Guards everything below
+    pthread_cond_t wake;        // Signalled when a job is posted or the pool stops
+    pthread_cond_t done;        // Signalled when the last worker leaves a job
+    t_worker *workers;
+    int num_workers;
+    int stop;
+    int busy;                   // A job is running (later callers run serially)
+    unsigned long generation;   // Incremented for every job
+
+    // Current job
+    t_range_fn body;
+    void *ctx;
+    t_slice *slices;
+    int slice_capacity;         // Kept from job to job
+    int participants;
+    int grain;                  // Indices per chunk
+    int active;                 // Workers still running the job
+} pool = {.lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER, .done = PTHREAD_COND_INITIALIZER};
+
+// Set on pool workers, and on the calling thread while it runs a job:
+// parallel_for from there runs serially instead of waiting on itself
+static _Thread_local int in_pool = 0;
+
+// Runs chunks of the job as participant `self` until no work is left anywhere
+static void pool_participate(int self) {
+    for (;;) {
+        pthread_mutex_lock(&pool.lock);
+        t_slice *own = &pool.slices[self];
+        if (own->next >= own->end) {
+            // Steal the back half of the largest slice left
+            int victim = -1, most = 0;
+            for (int p = 0; p < pool.participants; p++) {
+                int left = pool.slices[p].end - pool.slices[p].next;
+                if (left > most) {
+                    most = left;
+                    victim = p;
+                }
+            }
+            if (victim < 0) {
+                pthread_mutex_unlock(&pool.lock);
+                return;
+            }
+            int mid = pool.slices[victim].next + most / 2;
+            own->next = mid;
+            own->end = pool.slices[victim].end;
+            pool.slices[victim].end = mid;
+        }
+        int begin = own->next;
+        int end = (own->end - begin > pool.grain) ? begin + pool.grain : own->end;
+        own->next = end;
+        t_range_fn body = pool.body;
+        void *ctx = pool.ctx;
+        pthread_mutex_unlock(&pool.lock);
+
+        body(begin, end, ctx);
+    }
+}
+
+static void *pool_worker(void *arg) {
+    int index = (int)(intptr_t)arg;
+    in_pool = 1;
+
+    pthread_mutex_lock(&pool.lock);
+    unsigned long seen = pool.workers[index].generation;
+    for (;;) {
+        while (!pool.stop && pool.generation == seen) pthread_cond_wait(&pool.wake, &pool.lock);
+        if (pool.stop) break;
+        seen = pool.generation;
+        // Worker i is participant i + 1; jobs smaller than the pool leave the rest asleep
+        if (index + 1 >= pool.participants) continue;
+
+        pthread_mutex_unlock(&pool.lock);
+        pool_participate(index + 1);
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.active == 0) pthread_cond_signal(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+// Grows the pool to `count` workers (caller holds the lock). Returns the number running.
+static int pool_grow(int count) {
+    if (count <= pool.num_workers) return pool.num_workers;
+    t_worker *workers = (t_worker *)realloc(pool.workers, count * sizeof(t_worker));
+    if (!workers) return pool.num_workers;
+    pool.workers = workers;
+    while (pool.num_workers < count) {
+        // The job about to be posted counts as new for this worker
+        t_worker *w = &pool.workers[pool.num_workers];
+        w->generation = pool.generation;
+        if (pthread_create(&w->tid, NULL, pool_worker, (void *)(intptr_t)pool.num_workers) != 0) {
+            break;
+        }
+        pool.num_workers++;
+    }
+    return pool.num_workers;
+}
+
+void thread_pool_start(void) {
+    pthread_mutex_lock(&pool.lock);
+    pool_grow(get_num_threads() - 1);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+void thread_pool_stop(void) {
+    pthread_mutex_lock(&pool.lock);
+    pool.stop = 1;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+    for (int w = 0; w < pool.num_workers; w++) {
+        pthread_join(pool.workers[w].tid, NULL);
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    free(pool.workers);
+    pool.workers = NULL;
+    pool.num_workers = 0;
+    free(pool.slices);
+    pool.slices = NULL;
+    pool.slice_capacity = 0;
+    pool.stop = 0;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+void parallel_for(int begin, int end, t_range_fn body, void *ctx) {
+    int count = end - begin;
+    if (count <= 0) return;
+
+    int threads = get_num_threads();
+    if (threads > count) threads = count;
+    if (threads <= 1 || in_pool) {
+        body(begin, end, ctx);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    // One job at a time: another thread's parallel_for runs serially meanwhile.
+    // Workers that fail to start are simply not used.
+    t_slice *slices = NULL;
+    if (!pool.busy) {
+        int workers = pool_grow(threads - 1);
+        if (workers + 1 < threads) threads = workers + 1;
+        if (threads > 1 && threads > pool.slice_capacity) {
+            slices = (t_slice *)realloc(pool.slices, threads * sizeof(t_slice));
+            if (slices) {
+                pool.slices = slices;
+                pool.slice_capacity = threads;
+            }
+        }
+        if (threads > 1 && threads <= pool.slice_capacity) slices = pool.slices;
+    }
+    if (!slices) {
+        pthread_mutex_unlock(&pool.lock);
+        body(begin, end, ctx);
+        return;
+    }
+
+    for (int t = 0; t < threads; t++) {
+        slices[t].next = begin + (int)((long long)count * t / threads);
+        slices[t].end = begin + (int)((long long)count * (t + 1) / threads);
+    }
+    pool.busy = 1;
+    pool.body = body;
+    pool.ctx = ctx;
+    pool.participants = threads;
+    pool.grain = count / (threads * POOL_CHUNKS_PER_THREAD);
+    if (pool.grain < 1) pool.grain = 1;
+    pool.active = threads - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    in_pool = 1;
+    pool_participate(0);
+    in_pool = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.active > 0) pthread_cond_wait(&pool.done, &pool.lock);
+    pool.busy = 0;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+// --- Scratch memory ---
+
+static atomic_ulong arena_allocations = 0;
+
+static size_t arena_round(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+// size is a multiple of ARENA_ALIGNMENT
+static void *arena_heap(size_t size) {
+    void *memory = aligned_alloc(ARENA_ALIGNMENT, size);
+    if (memory) atomic_fetch_add(&arena_allocations, 1);
+    return memory;
+}
+
+void *arena_alloc(t_arena *arena, size_t size) {
+    if (!arena || size > SIZE_MAX / 2) return NULL;
+    size = arena_round(size ? size : 1);
+    size_t offset = arena->top;
+    void *memory;
+    if (offset + size <= arena->size) {
+        memory = arena->block + offset;
+    } else {
+        if (arena->numOverflow == arena->overflowCapacity) {
+            int capacity = arena->overflowCapacity ? 2 * arena->overflowCapacity : 8;
+            t_arena_overflow *overflow = (t_arena_overflow *)realloc(arena->overflow, capacity * sizeof(t_arena_overflow));
+            if (!overflow) return NULL;
+            atomic_fetch_add(&arena_allocations, 1);
+            arena->overflow = overflow;
+            arena->overflowCapacity = capacity;
+        }
+        memory = arena_heap(size);
+        if (!memory) return NULL;
+        arena->overflow[arena->numOverflow].memory = memory;
+        arena->overflow[arena->numOverflow].offset = offset;
+        arena->numOverflow++;
+    }
+    arena->top = offset + size;
+    if (arena->top > arena->peak) arena->peak = arena->top;
+    return memory;
+}
+
+void *arena_calloc(t_arena *arena, size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) return NULL;
+    void *memory = arena_alloc(arena, count * size);
+    if (memory) memset(memory, 0, count * size);
+    return memory;
+}
+
+size_t arena_mark(const t_arena *arena) {
+    return arena ? arena->top : 0;
+}
+
+void arena_release(t_arena *arena, size_t mark) {
+    if (!arena || mark > arena->top) return;
+    while (arena->numOverflow > 0 && arena->overflow[arena->numOverflow - 1].offset >= mark) {
+        free(arena->overflow[--arena->numOverflow].memory);
+    }
+    arena->top = mark;
+
+    // Empty: one block large enough for everything the operations have needed so far
+    if (mark == 0 && arena->peak > arena->size) {
+        free(arena->block);
+        arena->block = (uint8_t *)arena_heap(arena->peak);
+        arena->size = arena->block ? arena->peak : 0;
+    }
+}
+
+void arena_free(t_arena *arena) {
+    if (!arena) return;
+    for (int i = 0; i < arena->numOverflow; i++) free(arena->overflow[i].memory);
+    free(arena->overflow);
+    free(arena->block);
+    memset(arena, 0, sizeof(t_arena));
+}
+
+unsigned long arena_heap_allocations(void) {
+    return atomic_load(&arena_allocations);
+}
+
+// One arena per thread, freed by the key destructor when the thread exits
+static pthread_key_t scratch_key;
+static pthread_once_t scratch_once = PTHREAD_ONCE_INIT;
+
+static void scratch_destroy(void *arena) {
+    arena_free((t_arena *)arena);
+    free(arena);
+}
+
+static void scratch_key_create(void) {
+    pthread_key_create(&scratch_key, scratch_destroy);
+}
+
+t_arena *scratch_arena(void) {
+    pthread_once(&scratch_once, scratch_key_create);
+    t_arena *arena = (t_arena *)pthread_getspecific(scratch_key);
+    if (!arena) {
+        arena = (t_arena *)calloc(1, sizeof(t_arena));
+        if (!arena || pthread_setspecific(scratch_key, arena) != 0) {
+            perror("Error creating scratch arena");
+            free(arena);
+            return NULL;
+        }
+    }
+    return arena;
+}
+
+void scratch_arena_free(void) {
+    pthread_once(&scratch_once, scratch_key_create);
+    t_arena *arena = (t_arena *)pthread_getspecific(scratch_key);
+    if (!arena) return;
+    pthread_setspecific(scratch_key, NULL);
+    scratch_destroy(arena);
 }
 
 int clamp_int(int value, int min_val, int max_val) {
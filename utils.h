@@ -45,12 +45,31 @@ void file_rawRead(uint32_t position, void *buffer, uint32_t size, size_t n, FILE
 // Helper function for writing raw data to a file at a specific position
 void file_rawWrite(uint32_t position, void *buffer, uint32_t size, size_t n, FILE *file);
 
+// Maps a whole file into memory as a private (copy-on-write) mapping.
+// Writes through the returned pointer never reach the file.
+// Returns NULL on error; *size receives the mapping length.
+uint8_t *file_mapPrivate(const char *filename, size_t *size);
+
+// Releases a mapping obtained from file_mapPrivate
+void file_unmap(uint8_t *mapping, size_t size);
+
+// Returns 1 if both paths name the same existing file (same device and inode),
+// whatever the spelling of the paths, 0 otherwise
+int file_isSame(const char *a, const char *b);
+
 // Function to allocate a 2D kernel matrix
 float **allocate_kernel(int kernelSize);
 
 // Function to free a 2D kernel matrix
 void free_kernel(float **kernel, int kernelSize);
 
+// Builds a size x size box blur kernel (all weights 1 / size^2). Free with free_kernel.
+float **create_box_kernel(int kernelSize);
+
+// Builds a normalized size x size Gaussian kernel. sigma <= 0 picks one from the size.
+// Free with free_kernel.
+float **create_gaussian_kernel(int kernelSize, float sigma);
+
 // Predefined kernels
 extern float **BOX_BLUR_KERNEL;
 extern float **GAUSSIAN_BLUR_KERNEL;
@@ -59,12 +78,87 @@ extern float **EMBOSS_KERNEL;
 extern float **SHARPEN_KERNEL;
 extern const int KERNEL_SIZE_3x3;
 
-// Function to initialize global kernels
+// Function to initialize global kernels (and start the thread pool)
 void initialize_kernels();
 
-// Function to free global kernels
+// Function to free global kernels (and stop the thread pool and free the scratch arenas)
 void cleanup_kernels();
 
+// --- Parallelism ---
+
+// Number of threads the parallel filters use. n <= 0 restores the default
+// (one per online CPU).
+void set_num_threads(int n);
+int get_num_threads(void);
+
+// Work item for parallel_for: processes indices [begin, end)
+typedef void (*t_range_fn)(int begin, int end, void *ctx);
+
+// Runs body over [begin, end) on the thread pool and returns once every index
+// is done. Each thread starts on a contiguous band and runs it in a few chunks;
+// threads that finish early steal the back half of the largest band left, so
+// body is called on several sub-ranges and must not depend on how the range is
+// cut. Calls made from inside a body (or while another thread's job is running)
+// run serially on the calling thread.
+void parallel_for(int begin, int end, t_range_fn body, void *ctx);
+
+// Persistent workers behind parallel_for: get_num_threads() - 1 of them, the
+// thread calling parallel_for takes part as well. Started by initialize_kernels and stopped by
+// cleanup_kernels; parallel_for also starts or grows the pool on demand, so
+// calling these directly is only needed to release the threads early.
+void thread_pool_start(void);
+void thread_pool_stop(void);
+
+// --- Scratch memory ---
+
+// Stack-like allocator for the temporary buffers of an operation (row windows,
+// halos, histogram parts...). Buffers are taken with arena_alloc and handed back
+// all at once with arena_release(arena, mark); the memory stays with the arena
+// for the next operation. What does not fit is malloc'ed on the side, and once
+// the arena is empty again its block grows to the largest size used so far:
+// repeating an operation on images of the same size then allocates nothing.
+
+// Alignment of every arena buffer (one cache line)
+#define ARENA_ALIGNMENT 64
+
+typedef struct {
+    void *memory;
+    size_t offset;      // Arena offset the buffer was taken at
+} t_arena_overflow;
+
+typedef struct {
+    uint8_t *block;
+    size_t size;
+    size_t top;         // Bytes in use, counting overflow buffers
+    size_t peak;        // Largest top so far
+    t_arena_overflow *overflow; // Buffers that did not fit in the block, in order
+    int numOverflow;
+    int overflowCapacity;
+} t_arena;
+
+// Returns size bytes aligned to ARENA_ALIGNMENT, or NULL on error
+void *arena_alloc(t_arena *arena, size_t size);
+
+// Same, zeroed
+void *arena_calloc(t_arena *arena, size_t count, size_t size);
+
+// Everything allocated after arena_mark is given back by arena_release
+size_t arena_mark(const t_arena *arena);
+void arena_release(t_arena *arena, size_t mark);
+
+// Frees the memory of the arena (which can be used again afterwards)
+void arena_free(t_arena *arena);
+
+// Arena of the calling thread. Each thread that runs operations (the caller and
+// every pool worker) has its own, so bands running in parallel never share one.
+// A worker's arena is freed when the worker exits; scratch_arena_free releases
+// the calling thread's (cleanup_kernels does it for the main thread).
+t_arena *scratch_arena(void);
+void scratch_arena_free(void);
+
+// Number of blocks the arenas have malloc'ed so far, overflow buffers included
+unsigned long arena_heap_allocations(void);
+
 // Clamp a value between min and max
 int clamp_int(int value, int min_val, int max_val);
 float clamp_float(float value, float min_val, float max_val);